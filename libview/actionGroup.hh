@@ -48,7 +48,7 @@ public:
       return Glib::RefPtr<ActionGroup>(new ActionGroup(name, pos));
    }
 
-   int GetPos(void) { return mPos; }
+   int GetPos(void) const { return mPos; }
 
 protected:
    ActionGroup(const Glib::ustring &name = Glib::ustring(), int pos = 0)
@@ -0,0 +1,361 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * actionGroupRegistry.cc --
+ *
+ *      Implements the ActionGroupRegistry class.
+ */
+
+
+#include <algorithm>
+
+#include <libview/actionGroupRegistry.hh>
+
+
+namespace view {
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ActionGroupRegistry::Key::operator< --
+ *
+ *      Order by position, then by insertion order.
+ *
+ * Results:
+ *      true if this key sorts before other.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+ActionGroupRegistry::Key::operator<(const Key &other) // IN
+   const
+{
+   if (pos != other.pos) {
+      return pos < other.pos;
+   }
+   return serial < other.serial;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ActionGroupRegistry::ActionGroupRegistry --
+ *
+ *      Constructor. The registry starts out empty; groups already in
+ *      uiManager, or added to it later without the registry, are left
+ *      where they are.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+ActionGroupRegistry::ActionGroupRegistry(Glib::RefPtr<Gtk::UIManager> uiManager) // IN
+   : mUIManager(uiManager),
+     mNextSerial(0)
+{
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ActionGroupRegistry::Insert --
+ *
+ *      Insert groups into the UIManager, each at the index its
+ *      position calls for. Groups already registered are skipped.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The UI is brought up to date once, after the whole batch.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ActionGroupRegistry::Insert(const Glib::RefPtr<ActionGroup> &group) // IN
+{
+   Insert(GroupVector(1, group));
+}
+
+
+void
+ActionGroupRegistry::Insert(const GroupVector &groups) // IN
+{
+   bool changed = false;
+   for (GroupVector::size_type i = 0; i < groups.size(); i++) {
+      changed = InsertOne(groups[i]) || changed;
+   }
+   if (changed) {
+      mUIManager->ensure_update();
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ActionGroupRegistry::Remove --
+ *
+ *      Remove groups from the UIManager. Groups that aren't registered
+ *      are skipped.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The UI is brought up to date once, after the whole batch.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ActionGroupRegistry::Remove(const Glib::RefPtr<ActionGroup> &group) // IN
+{
+   Remove(GroupVector(1, group));
+}
+
+
+void
+ActionGroupRegistry::Remove(const GroupVector &groups) // IN
+{
+   bool changed = false;
+   for (GroupVector::size_type i = 0; i < groups.size(); i++) {
+      changed = RemoveOne(groups[i]) || changed;
+   }
+   if (changed) {
+      mUIManager->ensure_update();
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ActionGroupRegistry::Update --
+ *
+ *      Re-index the actions of a registered group. GtkActionGroup has
+ *      no signal for actions being added or removed, so callers that
+ *      change a group after inserting it must call this.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ActionGroupRegistry::Update(const Glib::RefPtr<ActionGroup> &group) // IN
+{
+   std::map<ActionGroup *, Record>::iterator i = mRecords.find(group.operator->());
+   if (i != mRecords.end()) {
+      UnindexActions(i->second);
+      IndexActions(group, i->second);
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ActionGroupRegistry::GetAction --
+ *
+ *      Look up an action by name across all registered groups. If
+ *      several groups have an action of that name, the one from the
+ *      first group in UIManager order wins, as with
+ *      Gtk::UIManager::get_action.
+ *
+ * Results:
+ *      The action, or a NULL RefPtr if there is none.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+Glib::RefPtr<Gtk::Action>
+ActionGroupRegistry::GetAction(const Glib::ustring &name) // IN
+   const
+{
+   ActionIndex::const_iterator i = mActions.find(name.raw());
+   if (i == mActions.end() || i->second.empty()) {
+      return Glib::RefPtr<Gtk::Action>();
+   }
+   return i->second.begin()->second;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ActionGroupRegistry::InsertOne --
+ *
+ *      Register one group and insert it into the UIManager, right
+ *      before the registered group that follows it. Groups in the
+ *      UIManager that aren't registered may sit anywhere, so that
+ *      group's index is looked up rather than assumed to match ours. A
+ *      group with no registered successor goes last.
+ *
+ * Results:
+ *      true if the group was inserted, false if already registered.
+ *
+ * Side effects:
+ *      The UIManager queues an update.
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+ActionGroupRegistry::InsertOne(const Glib::RefPtr<ActionGroup> &group) // IN
+{
+   if (!group || mRecords.find(group.operator->()) != mRecords.end()) {
+      return false;
+   }
+
+   Record &record = mRecords[group.operator->()];
+   record.key.pos = group->GetPos();
+   record.key.serial = mNextSerial++;
+
+   std::vector<Key>::iterator at =
+      std::upper_bound(mKeys.begin(), mKeys.end(), record.key);
+   int index = at - mKeys.begin();
+   mKeys.insert(at, record.key);
+   mGroups.insert(mGroups.begin() + index, group);
+
+   int managerIndex = -1;
+   if (index + 1 < static_cast<int>(mGroups.size())) {
+      managerIndex = g_list_index(
+         gtk_ui_manager_get_action_groups(mUIManager->gobj()),
+         mGroups[index + 1]->gobj());
+   }
+
+   IndexActions(group, record);
+   mUIManager->insert_action_group(group, managerIndex);
+   return true;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ActionGroupRegistry::RemoveOne --
+ *
+ *      Unregister one group and remove it from the UIManager.
+ *
+ * Results:
+ *      true if the group was removed, false if it wasn't registered.
+ *
+ * Side effects:
+ *      The UIManager queues an update.
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+ActionGroupRegistry::RemoveOne(const Glib::RefPtr<ActionGroup> &group) // IN
+{
+   std::map<ActionGroup *, Record>::iterator i = mRecords.find(group.operator->());
+   if (i == mRecords.end()) {
+      return false;
+   }
+
+   std::vector<Key>::iterator at =
+      std::lower_bound(mKeys.begin(), mKeys.end(), i->second.key);
+   int index = at - mKeys.begin();
+   mKeys.erase(at);
+   mGroups.erase(mGroups.begin() + index);
+
+   UnindexActions(i->second);
+   mRecords.erase(i);
+   mUIManager->remove_action_group(group);
+   return true;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ActionGroupRegistry::IndexActions --
+ * view::ActionGroupRegistry::UnindexActions --
+ *
+ *      Add a group's actions to the name index, remembering their
+ *      names in the group's record, or take them back out.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ActionGroupRegistry::IndexActions(const Glib::RefPtr<ActionGroup> &group, // IN
+                                  Record &record)                         // IN/OUT
+{
+   std::vector<Glib::RefPtr<Gtk::Action> > actions(group->get_actions());
+   for (std::vector<Glib::RefPtr<Gtk::Action> >::size_type i = 0;
+        i < actions.size(); i++) {
+      std::string name = actions[i]->get_name().raw();
+      mActions[name][record.key] = actions[i];
+      record.actionNames.push_back(name);
+   }
+}
+
+
+void
+ActionGroupRegistry::UnindexActions(Record &record) // IN/OUT
+{
+   for (std::vector<std::string>::size_type i = 0;
+        i < record.actionNames.size(); i++) {
+      ActionIndex::iterator j = mActions.find(record.actionNames[i]);
+      if (j != mActions.end()) {
+         j->second.erase(record.key);
+         if (j->second.empty()) {
+            mActions.erase(j);
+         }
+      }
+   }
+   record.actionNames.clear();
+}
+
+
+} // namespace view
@@ -0,0 +1,105 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * actionGroupRegistry.hh --
+ *
+ *      Keeps the view::ActionGroups of a Gtk::UIManager ordered by their
+ *      position. Groups are inserted into the UIManager at the index their
+ *      position calls for, lower positions first (and so taking precedence
+ *      in action lookup), in batches that end with a single UI update.
+ *
+ *      The registry also indexes actions by name across all its groups,
+ *      so GetAction doesn't have to search each group in turn.
+ */
+
+
+#ifndef LIBVIEW_ACTION_GROUP_REGISTRY_HH
+#define LIBVIEW_ACTION_GROUP_REGISTRY_HH
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <gtkmm/uimanager.h>
+
+#include <libview/actionGroup.hh>
+
+
+namespace view {
+
+
+class ActionGroupRegistry
+{
+public:
+   typedef std::vector<Glib::RefPtr<ActionGroup> > GroupVector;
+
+   ActionGroupRegistry(Glib::RefPtr<Gtk::UIManager> uiManager);
+
+   void Insert(const Glib::RefPtr<ActionGroup> &group);
+   void Insert(const GroupVector &groups);
+   void Remove(const Glib::RefPtr<ActionGroup> &group);
+   void Remove(const GroupVector &groups);
+   void Update(const Glib::RefPtr<ActionGroup> &group);
+
+   Glib::RefPtr<Gtk::Action> GetAction(const Glib::ustring &name) const;
+   const GroupVector &GetGroups(void) const { return mGroups; }
+
+private:
+   // Position, with insertion order breaking ties.
+   struct Key {
+      int pos;
+      unsigned long serial;
+
+      bool operator<(const Key &other) const;
+   };
+
+   struct Record {
+      Key key;
+      std::vector<std::string> actionNames;
+   };
+
+   typedef std::map<Key, Glib::RefPtr<Gtk::Action> > ActionsByKey;
+   typedef std::map<std::string, ActionsByKey> ActionIndex;
+
+   bool InsertOne(const Glib::RefPtr<ActionGroup> &group);
+   bool RemoveOne(const Glib::RefPtr<ActionGroup> &group);
+   void IndexActions(const Glib::RefPtr<ActionGroup> &group, Record &record);
+   void UnindexActions(Record &record);
+
+   Glib::RefPtr<Gtk::UIManager> mUIManager;
+
+   // Sorted by key; mKeys[i] is the key of mGroups[i].
+   GroupVector mGroups;
+   std::vector<Key> mKeys;
+
+   std::map<ActionGroup *, Record> mRecords;
+   ActionIndex mActions;
+   unsigned long mNextSerial;
+};
+
+
+} // namespace view
+
+
+#endif // LIBVIEW_ACTION_GROUP_REGISTRY_HH
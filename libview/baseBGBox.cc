@@ -48,6 +48,9 @@
  *      The added bonus is that because we no-longer inherit from
  *      EventBox, crux and smokey-blue will not override our rendering
  *      style.
+ *
+ *      Only the exposed parts of the allocation are painted. The number
+ *      of pixels painted is counted so overdraw can be measured.
  */
 
 #include <libview/baseBGBox.hh>
@@ -73,8 +76,58 @@ namespace view {
  */
 
 BaseBGBox::BaseBGBox(Palette palette) // IN
-   : mPalette(palette)
+   : mPalette(palette),
+     mGCState(Gtk::STATE_NORMAL),
+     mPaintedPixels(0)
+{
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::BaseBGBox::GetGC --
+ *
+ *      Get the style's GC for the palette in the current state. The
+ *      GC is cached along with the style and state it came from, so
+ *      style and state changes are picked up on the next expose. The
+ *      style is held on to so it can't be freed and replaced by
+ *      another at the same address.
+ *
+ * Results:
+ *      The GC.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+Glib::RefPtr<Gdk::GC>
+BaseBGBox::GetGC(void)
 {
+   Glib::RefPtr<Gtk::Style> style = get_style();
+   Gtk::StateType state = get_state();
+   if (mGC && style == mGCStyle && state == mGCState) {
+      return mGC;
+   }
+
+   switch (mPalette) {
+   case BASE:
+      mGC = style->get_base_gc(state);
+      break;
+   case BG:
+      mGC = style->get_bg_gc(state);
+      break;
+   case FG:
+      mGC = style->get_fg_gc(state);
+      break;
+   default:
+      g_assert_not_reached();
+   }
+   mGCStyle = style;
+   mGCState = state;
+   return mGC;
 }
 
 
@@ -83,8 +136,8 @@ BaseBGBox::BaseBGBox(Palette palette) // IN
  *
  * view::BaseBGBox::on_expose_event --
  *
- *      Expose event handler. Paint the background of the widget using
- *      the current state's base colour.
+ *      Expose event handler. Paint the exposed part of the widget's
+ *      background using the current state's colour from the palette.
  *
  * Results:
  *      Result of parent handler.
@@ -99,28 +152,33 @@ bool
 BaseBGBox::on_expose_event(GdkEventExpose *event) // IN
 {
    if (is_drawable()) {
-      const Gtk::Allocation allocation(get_allocation());
-
-      // Don't cache the gc to avoid worrying about style changes.
-      Glib::RefPtr<Gtk::Style> style = get_style();
-      Gtk::StateType state = get_state();
-      Glib::RefPtr<Gdk::GC> gc;
-      switch (mPalette) {
-      case BASE:
-         gc = style->get_base_gc(state);
-         break;
-      case BG:
-         gc = style->get_bg_gc(state);
-         break;
-      case FG:
-         gc = style->get_fg_gc(state);
-         break;
-      default:
-         g_assert_not_reached();
+      Gtk::Allocation allocation(get_allocation());
+      Glib::RefPtr<Gdk::GC> gc = GetGC();
+      Glib::RefPtr<Gdk::Window> window = get_window();
+
+      /*
+       * Paint each rectangle of the exposed region rather than its
+       * bounding box, so that e.g. two small damaged corners don't
+       * repaint everything in between.
+       */
+      GdkRectangle *rects = &event->area;
+      int nRects = 1;
+      if (event->region) {
+         gdk_region_get_rectangles(event->region, &rects, &nRects);
+      }
+
+      for (int i = 0; i < nRects; i++) {
+         GdkRectangle area;
+         if (gdk_rectangle_intersect(&rects[i], allocation.gobj(), &area)) {
+            window->draw_rectangle(gc, true,
+                                   area.x, area.y, area.width, area.height);
+            mPaintedPixels += area.width * area.height;
+         }
+      }
+
+      if (event->region) {
+         g_free(rects);
       }
-      get_window()->draw_rectangle(gc, true,
-                                   allocation.get_x(), allocation.get_y(),
-                                   allocation.get_width(), allocation.get_height());
    }
    return Gtk::HBox::on_expose_event(event);
 }
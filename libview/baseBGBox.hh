@@ -48,6 +48,9 @@
  *      The added bonus is that because we no-longer inherit from
  *      EventBox, crux and smokey-blue will not override our rendering
  *      style. 
+ *
+ *      Only the exposed parts of the allocation are painted. The number
+ *      of pixels painted is counted so overdraw can be measured.
  */
 
 #ifndef LIBVIEW_BASEBGBOX_HH
@@ -68,11 +71,21 @@ public:
 
    BaseBGBox(Palette = BASE);
 
+   guint64 GetPaintedPixels(void) const { return mPaintedPixels; }
+
 protected:
    bool on_expose_event(GdkEventExpose *event);
 
 private:
+   Glib::RefPtr<Gdk::GC> GetGC(void);
+
    Palette mPalette;
+
+   Glib::RefPtr<Gdk::GC> mGC;
+   Glib::RefPtr<Gtk::Style> mGCStyle;
+   Gtk::StateType mGCState;
+
+   guint64 mPaintedPixels;
 };
 
 
@@ -54,7 +54,7 @@ namespace view {
 
 DeadEntry::DeadEntry(void)
    : Gtk::Entry(),
-     mStyleChangedRunning(false)
+     mInsensitive(false)
 {
    property_editable().signal_changed().connect(
 	sigc::mem_fun(this, &DeadEntry::EditableChanged));
@@ -90,25 +90,54 @@ DeadEntry::DeadEntry(void)
 void
 DeadEntry::EditableChanged(void)
 {
+   /*
+    * Each modify_base()/modify_text()/unset_*() call resets the style and
+    * emits "style_set", which on a theme change means several full style
+    * lookups per entry. Change both colours through the modifier style
+    * instead, which costs a single reset, and only when they actually
+    * differ from what the entry has.
+    */
+   Glib::RefPtr<Gtk::RcStyle> modifier = get_modifier_style();
+   Gtk::RcFlags flags = modifier->get_color_flags(Gtk::STATE_NORMAL);
+
    if (get_editable()) {
+      if (!mInsensitive) {
+         return;
+      }
+      mInsensitive = false;
+
       /* Reset the colors */
-      unset_base(Gtk::STATE_NORMAL);
-      unset_text(Gtk::STATE_NORMAL);
+      modifier->set_color_flags(Gtk::STATE_NORMAL,
+                                flags & ~(Gtk::RC_BASE | Gtk::RC_TEXT));
    } else {
       ensure_style();
 
-      modify_base(Gtk::STATE_NORMAL,
-		  get_style()->get_base(Gtk::STATE_INSENSITIVE));
-      modify_text(Gtk::STATE_NORMAL,
-		  get_style()->get_text(Gtk::STATE_INSENSITIVE));
+      Glib::RefPtr<Gtk::Style> style = get_style();
+      Gdk::Color base = style->get_base(Gtk::STATE_INSENSITIVE);
+      Gdk::Color text = style->get_text(Gtk::STATE_INSENSITIVE);
+      if (mInsensitive &&
+          gdk_color_equal(style->get_base(Gtk::STATE_NORMAL).gobj(),
+                          base.gobj()) &&
+          gdk_color_equal(style->get_text(Gtk::STATE_NORMAL).gobj(),
+                          text.gobj())) {
+         return;
+      }
+      mInsensitive = true;
+
+      modifier->set_base(Gtk::STATE_NORMAL, base);
+      modifier->set_text(Gtk::STATE_NORMAL, text);
+      modifier->set_color_flags(Gtk::STATE_NORMAL,
+                                flags | Gtk::RC_BASE | Gtk::RC_TEXT);
    }
+
+   modify_style(modifier);
 }
 
 
 /*
  *-----------------------------------------------------------------------------
  *
- * view::DeadEntry::StyleSet --
+ * view::DeadEntry::StyleChanged --
  *
  *      "style_set" Signal handler.  Calls EditableChanged() to reapply style
  *      modifications using the new theme.
@@ -126,14 +155,10 @@ void
 DeadEntry::StyleChanged(const Glib::RefPtr<Gtk::Style> &oldStyle) // IN
 {
    /*
-    * modify_base/text() emit another style_set signal. So avoid a recursion
-    * crash...
+    * Applying the colors emits another style_set signal. That one finds
+    * the colors already applied and stops there.
     */
-   if (!mStyleChangedRunning) {
-      mStyleChangedRunning = true;
-      EditableChanged();
-      mStyleChangedRunning = false;
-   }
+   EditableChanged();
 }
 
 
@@ -34,6 +34,7 @@
 
 
 #include <gtkmm/entry.h>
+#include <gtkmm/rc.h>
 #include <gtkmm/style.h>
 
 
@@ -50,7 +51,7 @@ private:
    void EditableChanged(void);
    void StyleChanged(const Glib::RefPtr<Gtk::Style> &oldStyle);
 
-   bool mStyleChangedRunning;
+   bool mInsensitive;
 };
 
 
@@ -38,6 +38,10 @@
 namespace view {
 
 
+std::set<FieldEntry*> FieldEntry::sRelayoutPending;
+sigc::connection FieldEntry::sRelayoutIdle;
+
+
 /*
  *-----------------------------------------------------------------------------
  *
@@ -62,7 +66,9 @@ FieldEntry::FieldEntry(size_t fieldCount,               // IN: Number of fields
    : mFieldAlignment(fieldAlignment),
      mMaxFieldWidth(maxFieldWidth),
      mDelim(delim),
-     mTabs(0)
+     mTabs(0),
+     mDelimWidth(0),
+     mMetricsValid(false)
 {
    g_return_if_fail(fieldCount > 0);
    g_return_if_fail(delim != '\0');
@@ -89,10 +95,42 @@ FieldEntry::FieldEntry(size_t fieldCount,               // IN: Number of fields
 
    Field f;
    f.dirty = false;
+   f.maxTextWidth = 0;
    mFields.resize(fieldCount, f);
 
    ComputeLayout();
    ApplyLayout();
+
+   /*
+    * GetAllowedFieldChars() is virtual, so the metrics computed from here
+    * don't know about subclasses. Measure again when first needed.
+    */
+   mMetricsValid = false;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::FieldEntry::~FieldEntry --
+ *
+ *      Destructor.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      The entry no longer gets a pending relayout.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+FieldEntry::~FieldEntry()
+{
+   sRelayoutPending.erase(this);
+   if (sRelayoutPending.empty()) {
+      sRelayoutIdle.disconnect();
+   }
 }
 
 
@@ -400,6 +438,9 @@ FieldEntry::IsFieldValid(const Glib::ustring& str) // IN: New data
  *      can be used. This is intended for subclasses to override. By default,
  *      any character is allowed (aside from tabs and delimiters).
  *
+ *      The field widths measured from these characters are kept until the
+ *      style changes, so they shouldn't change over the entry's life.
+ *
  * Results:
  *      An empty string.
  *
@@ -475,6 +516,10 @@ FieldEntry::get_chars_vfunc(int startPos, // IN:
  *          that, we set our tab stops in the GtkEntry's PangoLayout everytime
  *          the entry is exposed. --hpreg
  *
+ *      The layout itself only needs computing again if the style changed
+ *      since it was last computed; every other change recomputes it
+ *      right away.
+ *
  * Results:
  *      None.
  *
@@ -487,7 +532,9 @@ FieldEntry::get_chars_vfunc(int startPos, // IN:
 bool
 FieldEntry::on_expose_event(GdkEventExpose* event) // IN: Event
 {
-   ComputeLayout();
+   if (!mMetricsValid) {
+      ComputeLayout();
+   }
    ApplyLayout();
 
    return DeadEntry::on_expose_event(event);
@@ -815,6 +862,133 @@ FieldEntry::on_size_request(Gtk::Requisition* requisition) // OUT:
 }
 
 
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::FieldEntry::on_style_changed --
+ *
+ *      Overridden "style_set" handler. The field widths depend on the font,
+ *      so they are measured again, but not right now: a theme or font
+ *      change sets the style of every entry, often several times over, so
+ *      the relayout of all entries is deferred to a single idle pass.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      Schedules OnRelayoutIdle().
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+FieldEntry::on_style_changed(const Glib::RefPtr<Gtk::Style>& previousStyle) // IN:
+{
+   DeadEntry::on_style_changed(previousStyle);
+
+   mMetricsValid = false;
+   sRelayoutPending.insert(this);
+
+   /*
+    * Run ahead of the resize and redraw GTK+ queues for the new style, so
+    * that those see the new layout.
+    */
+   if (!sRelayoutIdle.connected()) {
+      sRelayoutIdle = Glib::signal_idle().connect(
+         sigc::ptr_fun(&FieldEntry::OnRelayoutIdle), G_PRIORITY_HIGH_IDLE);
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::FieldEntry::OnRelayoutIdle --
+ *
+ *      Idle handler that lays out again every entry whose style changed,
+ *      keeping the cursor in the same place in its field. Entries that
+ *      were already laid out since, e.g. by a size request, are skipped.
+ *
+ * Results:
+ *      false to remove the idle handler.
+ *
+ * Side effects:
+ *      May emit fieldTextChanged.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+bool
+FieldEntry::OnRelayoutIdle()
+{
+   /*
+    * Take the entries out one at a time: laying one out can run handlers
+    * that destroy another, and ~FieldEntry only removes itself from the
+    * static set.
+    */
+   while (!sRelayoutPending.empty()) {
+      FieldEntry *entry = *sRelayoutPending.begin();
+      sRelayoutPending.erase(sRelayoutPending.begin());
+      if (entry->mMetricsValid) {
+         continue;
+      }
+
+      size_t posInField;
+      size_t field = entry->GetCurrentField(&posInField);
+
+      entry->ComputeLayout();
+      entry->ApplyLayout();
+
+      entry->SetCurrentField(field, posInField);
+   }
+
+   return false;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::FieldEntry::ComputeMetrics --
+ *
+ *      Measure the delimiter and the widest text each field can hold. These
+ *      only depend on the font, so they are kept until the style changes.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      Updates mDelimWidth and the fields' maxTextWidth.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+FieldEntry::ComputeMetrics()
+{
+   if (mMetricsValid) {
+      return;
+   }
+
+   Glib::RefPtr<Pango::Layout> layout =
+      create_pango_layout(Glib::ustring(1, mDelim));
+   int height;
+   layout->get_pixel_size(mDelimWidth, height);
+
+   for (size_t i = 0; i < GetFieldCount(); i++) {
+      Glib::ustring allowedChars = GetAllowedFieldChars(i);
+      if (allowedChars == "") {
+         allowedChars = "W";
+      }
+
+      mFields[i].maxTextWidth =
+         utils::GetLargestCharStrWidth(*this, allowedChars, mMaxFieldWidth);
+   }
+
+   mMetricsValid = true;
+}
+
+
 /*
  *-----------------------------------------------------------------------------
  *
@@ -836,19 +1010,13 @@ FieldEntry::on_size_request(Gtk::Requisition* requisition) // OUT:
 void
 FieldEntry::ComputeLayout()
 {
+   ComputeMetrics();
+
    /* Use the max size initially. */
    mTabs.resize(2 * GetFieldCount());
 
-   /*
-    * We can't cache these values, as the theme or font might change.
-    * We could listen for when the theme or font properties change, but
-    * that's a bit more work than we really should need to do right now.
-    */
-   Glib::RefPtr<Pango::Layout> layout =
-      create_pango_layout(Glib::ustring(1, mDelim));
-   int delimWidth;
+   Glib::RefPtr<Pango::Layout> layout = create_pango_layout("");
    int height;
-   layout->get_pixel_size(delimWidth, height);
 
    int offset = 0;
    mMarkedUp = "";
@@ -859,13 +1027,7 @@ FieldEntry::ComputeLayout()
       layout->set_text(mFields[i].val);
       layout->get_pixel_size(textWidth, height);
 
-      Glib::ustring allowedChars = GetAllowedFieldChars(i);
-      if (allowedChars == "") {
-         allowedChars = "W";
-      }
-
-      int maxTextWidth = utils::GetLargestCharStrWidth(*this, allowedChars,
-                                                       mMaxFieldWidth);
+      int maxTextWidth = mFields[i].maxTextWidth;
 
       int fieldOffset;
 
@@ -921,7 +1083,7 @@ FieldEntry::ComputeLayout()
 
       if (i != GetFieldCount() - 1) {
          mMarkedUp += mDelim;
-         offset += delimWidth;
+         offset += mDelimWidth;
       }
 
       mMaxTextWidth = offset;
@@ -34,6 +34,8 @@
 #define LIBVIEW_FIELDENTRY_HH
 
 
+#include <set>
+
 #include <libview/deadEntry.hh>
 
 
@@ -49,6 +51,7 @@ public:
    FieldEntry(size_t fieldCount, size_t maxFieldWidth,
               Glib::ustring::value_type delim,
               Alignment fieldAlignment = CENTER);
+   ~FieldEntry();
 
    void SetText(const Glib::ustring& text);
    Glib::ustring GetText(void) const;
@@ -75,6 +78,7 @@ protected:
    virtual void delete_text_vfunc(int startPos, int endPos);
    virtual void set_position_vfunc(int position);
    virtual void on_size_request(Gtk::Requisition* requisition);
+   virtual void on_style_changed(const Glib::RefPtr<Gtk::Style>& previousStyle);
 
 private:
    static const Glib::ustring::value_type sTabChar = '\t';
@@ -83,10 +87,14 @@ private:
       size_t pos;
       Glib::ustring val;
       bool dirty;
+      int maxTextWidth;
    };
 
+   static bool OnRelayoutIdle();
+
    void OnScrollOffsetChanged();
    void SetField(size_t field, const Glib::ustring& text);
+   void ComputeMetrics();
    void ComputeLayout();
    void ApplyLayout();
    void Position2Field(size_t position, size_t &field,
@@ -100,6 +108,11 @@ private:
    std::vector<Field> mFields;
    Pango::TabArray mTabs;
    Glib::ustring mMarkedUp;
+   int mDelimWidth;
+   bool mMetricsValid;
+
+   static std::set<FieldEntry*> sRelayoutPending;
+   static sigc::connection sRelayoutIdle;
 };
 
 
@@ -0,0 +1,305 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * frameAtlas.cc --
+ *
+ *      Implements the FrameAtlas class.
+ */
+
+
+#include <algorithm>
+#include <gtk/gtkversion.h>
+
+#include <libview/frameAtlas.hh>
+
+
+namespace view {
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameAtlas::FrameAtlas --
+ *
+ *      Constructor. The atlas starts out empty.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+FrameAtlas::FrameAtlas()
+   : mPartialAlpha(false),
+     mWidth(0),
+     mHeight(0)
+{
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameAtlas::SetFrames --
+ *
+ *      Set the frames of the atlas. The rest frame, if any, is stored
+ *      after the animation frames, so its index is frames.size().
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Any uploaded pixmaps are dropped; they are rebuilt on demand.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+FrameAtlas::SetFrames(const FrameVector &frames,                  // IN
+                      const Glib::RefPtr<Gdk::Pixbuf> &restFrame) // IN
+{
+   mFrames = frames;
+   if (restFrame) {
+      mFrames.push_back(restFrame);
+   }
+
+   mCells.clear();
+   mPartialAlpha = false;
+   mWidth = 0;
+   mHeight = 0;
+   for (FrameVector::size_type i = 0; i < mFrames.size(); i++) {
+      if (HasPartialAlpha(mFrames[i])) {
+         mPartialAlpha = true;
+      }
+      mCells.push_back(Gdk::Rectangle(mWidth, 0, mFrames[i]->get_width(),
+                                      mFrames[i]->get_height()));
+      mWidth += mFrames[i]->get_width();
+      mHeight = std::max(mHeight, mFrames[i]->get_height());
+   }
+
+   mEntries.clear();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameAtlas::HasPartialAlpha --
+ *
+ *      Check whether a frame has pixels that are neither opaque nor
+ *      fully transparent.
+ *
+ * Results:
+ *      true if it does.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+FrameAtlas::HasPartialAlpha(const Glib::RefPtr<Gdk::Pixbuf> &frame) // IN
+{
+   if (!frame->get_has_alpha()) {
+      return false;
+   }
+
+   const guint8 *pixels = frame->get_pixels();
+   int rowstride = frame->get_rowstride();
+   int channels = frame->get_n_channels();
+   for (int y = 0; y < frame->get_height(); y++) {
+      const guint8 *p = pixels + y * rowstride + channels - 1;
+      for (int x = 0; x < frame->get_width(); x++, p += channels) {
+         if (*p != 0 && *p != 0xff) {
+            return true;
+         }
+      }
+   }
+   return false;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameAtlas::GetEntry --
+ *
+ *      Find the uploaded copy of the atlas suitable for a widget,
+ *      uploading it if there is none yet. There is at most one per
+ *      screen and depth.
+ *
+ * Results:
+ *      The entry, or NULL if the widget isn't realized, there are no
+ *      frames, or they have partial alpha and the screen can't
+ *      composite them.
+ *
+ * Side effects:
+ *      May create a pixmap and mask on the X server.
+ *
+ *-------------------------------------------------------------------
+ */
+
+FrameAtlas::Entry *
+FrameAtlas::GetEntry(Gtk::Widget &widget) // IN
+{
+   Glib::RefPtr<Gdk::Window> window = widget.get_window();
+   if (!window || mFrames.empty()) {
+      return NULL;
+   }
+
+   Glib::RefPtr<Gdk::Screen> screen = widget.get_screen();
+   int depth = window->get_depth();
+
+   for (std::vector<Entry>::size_type i = 0; i < mEntries.size(); i++) {
+      Entry &entry = mEntries[i];
+      if (entry.screen == screen && entry.depth == depth) {
+         return &entry;
+      }
+   }
+
+   Entry entry;
+   entry.screen = screen;
+   entry.depth = depth;
+
+   if (mPartialAlpha) {
+#if GTK_CHECK_VERSION(2, 10, 0)
+      GdkColormap *rgba = gdk_screen_get_rgba_colormap(screen->gobj());
+      if (!rgba) {
+         return NULL;
+      }
+
+      entry.pixmap = Gdk::Pixmap::create(window, mWidth, mHeight, 32);
+      gdk_drawable_set_colormap(GDK_DRAWABLE(entry.pixmap->gobj()), rgba);
+
+      // Copy the frames with their alpha; nothing is composited yet.
+      cairo_t *cr = gdk_cairo_create(GDK_DRAWABLE(entry.pixmap->gobj()));
+      cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+      for (FrameVector::size_type i = 0; i < mFrames.size(); i++) {
+         const Gdk::Rectangle &cell = mCells[i];
+
+         gdk_cairo_set_source_pixbuf(cr, mFrames[i]->gobj(),
+                                     cell.get_x(), cell.get_y());
+         cairo_rectangle(cr, cell.get_x(), cell.get_y(),
+                         cell.get_width(), cell.get_height());
+         cairo_fill(cr);
+      }
+      cairo_destroy(cr);
+#else
+      return NULL;
+#endif
+   } else {
+      entry.pixmap = Gdk::Pixmap::create(window, mWidth, mHeight, depth);
+
+      std::vector<char> bits(((mWidth + 7) / 8) * mHeight, 0);
+      entry.mask = Gdk::Bitmap::create(window, &bits[0], mWidth, mHeight);
+
+      /*
+       * Every pixel is opaque or fully transparent, so the mask carries
+       * the whole alpha channel and what the pixmap holds under the
+       * transparent pixels never shows.
+       */
+      Glib::RefPtr<Gdk::GC> gc = Gdk::GC::create(window);
+      for (FrameVector::size_type i = 0; i < mFrames.size(); i++) {
+         const Gdk::Rectangle &cell = mCells[i];
+
+         entry.pixmap->draw_pixbuf(gc, mFrames[i], 0, 0,
+                                   cell.get_x(), cell.get_y(),
+                                   cell.get_width(), cell.get_height(),
+                                   Gdk::RGB_DITHER_NORMAL, 0, 0);
+         mFrames[i]->render_threshold_alpha(entry.mask, 0, 0,
+                                            cell.get_x(), cell.get_y(),
+                                            cell.get_width(),
+                                            cell.get_height(), 128);
+      }
+
+      entry.gc = Gdk::GC::create(window);
+      entry.gc->set_clip_mask(entry.mask);
+   }
+
+   mEntries.push_back(entry);
+   return &mEntries.back();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameAtlas::Draw --
+ *
+ *      Draw a frame on a widget's window by copying or compositing it
+ *      from the server side atlas.
+ *
+ * Results:
+ *      true if the frame was drawn, false if the caller should draw it
+ *      some other way.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+FrameAtlas::Draw(Gtk::Widget &widget, // IN
+                 int frame,           // IN: Index, as passed to SetFrames
+                 int x,               // IN
+                 int y)               // IN
+{
+   if (frame < 0 || frame >= static_cast<int>(mCells.size())) {
+      return false;
+   }
+
+   Entry *entry = GetEntry(widget);
+   if (!entry) {
+      return false;
+   }
+
+   const Gdk::Rectangle &cell = mCells[frame];
+   if (entry->mask) {
+      entry->gc->set_clip_origin(x - cell.get_x(), y - cell.get_y());
+      widget.get_window()->draw_drawable(entry->gc, entry->pixmap,
+                                         cell.get_x(), cell.get_y(), x, y,
+                                         cell.get_width(), cell.get_height());
+      return true;
+   }
+
+#if GTK_CHECK_VERSION(2, 10, 0)
+   cairo_t *cr = gdk_cairo_create(GDK_DRAWABLE(widget.get_window()->gobj()));
+   gdk_cairo_set_source_pixmap(cr, entry->pixmap->gobj(),
+                               x - cell.get_x(), y - cell.get_y());
+   cairo_rectangle(cr, x, y, cell.get_width(), cell.get_height());
+   cairo_fill(cr);
+   cairo_destroy(cr);
+   return true;
+#else
+   return false;
+#endif
+}
+
+
+} // namespace view
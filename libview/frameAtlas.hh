@@ -0,0 +1,94 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * frameAtlas.hh --
+ *
+ *      A strip of animation frames uploaded once to the X server. For
+ *      each screen and depth it is drawn on, the atlas keeps a server-side
+ *      pixmap holding every frame, so drawing a frame sends a few requests
+ *      rather than the frame's pixels, which matters over remote X.
+ *
+ *      Frames whose pixels are all opaque or fully transparent go in a
+ *      pixmap of the window's depth with a 1-bit mask, and are drawn with
+ *      XCopyArea through the mask. Frames with partial alpha go in a
+ *      32-bit ARGB pixmap and are composited over whatever is behind them
+ *      by the server, through cairo and RENDER, so anti-aliased edges
+ *      blend with themed backgrounds too. Screens without an ARGB visual
+ *      leave those frames to the caller to draw.
+ */
+
+#ifndef LIBVIEW_FRAME_ATLAS_HH
+#define LIBVIEW_FRAME_ATLAS_HH
+
+
+#include <vector>
+#include <gdkmm/bitmap.h>
+#include <gdkmm/gc.h>
+#include <gdkmm/pixbuf.h>
+#include <gdkmm/pixmap.h>
+#include <gtkmm/widget.h>
+
+
+namespace view {
+
+
+class FrameAtlas
+{
+public:
+   typedef std::vector<Glib::RefPtr<Gdk::Pixbuf> > FrameVector;
+
+   FrameAtlas();
+
+   void SetFrames(const FrameVector &frames,
+                  const Glib::RefPtr<Gdk::Pixbuf> &restFrame);
+
+   bool Draw(Gtk::Widget &widget, int frame, int x, int y);
+
+private:
+   struct Entry
+   {
+      Glib::RefPtr<Gdk::Screen> screen;
+      int depth;
+      Glib::RefPtr<Gdk::Pixmap> pixmap;
+      // Only for frames without partial alpha; else pixmap is ARGB.
+      Glib::RefPtr<Gdk::Bitmap> mask;
+      Glib::RefPtr<Gdk::GC> gc;
+   };
+
+   Entry *GetEntry(Gtk::Widget &widget);
+   static bool HasPartialAlpha(const Glib::RefPtr<Gdk::Pixbuf> &frame);
+
+   FrameVector mFrames;
+   bool mPartialAlpha;
+   std::vector<Gdk::Rectangle> mCells;
+   int mWidth;
+   int mHeight;
+   std::vector<Entry> mEntries;
+};
+
+
+} // namespace view
+
+
+#endif // LIBVIEW_FRAME_ATLAS_HH
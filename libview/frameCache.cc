@@ -0,0 +1,510 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * frameCache.cc --
+ *
+ *      Implements the FrameCache class.
+ */
+
+
+
+
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include <libview/frameCache.hh>
+#include <libview/imageScaler.hh>
+
+
+namespace view {
+
+
+FrameCache::EntryMap FrameCache::sEntries;
+unsigned long FrameCache::sDecodeCount = 0;
+Glib::ThreadPool *FrameCache::sPool = NULL;
+Glib::Dispatcher *FrameCache::sDispatcher = NULL;
+Glib::StaticMutex FrameCache::sMutex = GLIBMM_STATIC_MUTEX_INIT;
+std::vector<FrameCache::Entry *> FrameCache::sDone;
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::Key::operator< --
+ *
+ *      Strict weak ordering for the entry map.
+ *
+ * Results:
+ *      true if this key sorts before other.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+FrameCache::Key::operator<(const Key &other) // IN
+   const
+{
+   if (filename != other.filename) {
+      return filename < other.filename;
+   }
+   if (mtime != other.mtime) {
+      return mtime < other.mtime;
+   }
+   if (frameSize != other.frameSize) {
+      return frameSize < other.frameSize;
+   }
+   if (targetW != other.targetW) {
+      return targetW < other.targetW;
+   }
+   return targetH < other.targetH;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::Entry::Entry --
+ *
+ *      Constructor. The entry starts out unloaded and unreferenced.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+FrameCache::Entry::Entry(const Key &key) // IN
+   : mKey(key),
+     mRefCount(0),
+     mLoaded(false),
+     mLoading(false),
+     mSourceWidth(0),
+     mAtlas(NULL),
+     mCols(0),
+     mRows(0)
+{
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::Entry::~Entry --
+ *
+ *      Destructor. Drops a decoded atlas that was never wrapped.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+FrameCache::Entry::~Entry()
+{
+   if (mAtlas) {
+      g_object_unref(mAtlas);
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::Acquire --
+ *
+ *      Look up the entry for an image file cut into frameSize square
+ *      frames, each scaled to targetW x targetH, creating it if there
+ *      is none. A frameSize of zero treats the whole image as a single
+ *      frame.
+ *
+ *      The file's modification time is part of the key, so a file
+ *      rewritten in place is not served from a stale entry.
+ *
+ * Results:
+ *      The entry, with a reference held for the caller. It may not be
+ *      loaded yet.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+FrameCache::Entry *
+FrameCache::Acquire(const std::string &filename, // IN
+                    int frameSize,               // IN
+                    int targetW,                 // IN
+                    int targetH)                 // IN
+{
+   Key key;
+   key.filename = filename;
+   key.mtime = 0;
+   key.frameSize = frameSize;
+   key.targetW = targetW;
+   key.targetH = targetH;
+
+   struct stat st;
+   if (g_stat(filename.c_str(), &st) == 0) {
+      key.mtime = st.st_mtime;
+   }
+
+   Entry *entry;
+   EntryMap::iterator i = sEntries.find(key);
+   if (i != sEntries.end()) {
+      entry = i->second;
+   } else {
+      entry = new Entry(key);
+      sEntries[key] = entry;
+   }
+
+   entry->mRefCount++;
+   return entry;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::Release --
+ *
+ *      Drop a reference taken by Acquire(). NULL is ignored.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The last release removes the entry from the cache and frees it,
+ *      or leaves it to OnDecodesDone() if a decode is still running.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+FrameCache::Release(Entry *entry) // IN
+{
+   if (!entry || --entry->mRefCount > 0) {
+      return;
+   }
+
+   sEntries.erase(entry->mKey);
+   if (!entry->mLoading) {
+      delete entry;
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::Load --
+ *
+ *      Decode an entry on the calling (main) thread unless it is
+ *      already loaded. An entry already being decoded on the pool is
+ *      left to finish there.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Emits the entry's loaded signal.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+FrameCache::Load(Entry *entry) // IN
+{
+   if (entry->mLoaded || entry->mLoading) {
+      return;
+   }
+
+   sDecodeCount++;
+   Decode(entry);
+   Wrap(entry);
+   entry->mLoaded = true;
+   entry->loaded.emit();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::LoadAsync --
+ *
+ *      Queue an entry to be decoded on the worker pool unless it is
+ *      already loaded or queued.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Creates the worker pool and dispatcher on first use. The
+ *      entry's loaded signal is emitted from the main loop later.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+FrameCache::LoadAsync(Entry *entry) // IN
+{
+   if (entry->mLoaded || entry->mLoading) {
+      return;
+   }
+
+   if (!sPool) {
+#if !GLIB_CHECK_VERSION(2, 32, 0)
+      if (!Glib::thread_supported()) {
+         Glib::thread_init();
+      }
+#endif
+      sDispatcher = new Glib::Dispatcher();
+      sDispatcher->connect(sigc::ptr_fun(&FrameCache::OnDecodesDone));
+      sPool = new Glib::ThreadPool(2);
+   }
+
+   sDecodeCount++;
+   entry->mLoading = true;
+   sPool->push(sigc::bind(sigc::ptr_fun(&FrameCache::DecodeAsync), entry));
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::Decode --
+ *
+ *      Decode an entry's image file, and scale the frames it is cut
+ *      into to the target size. Safe to call from any thread as long
+ *      as nothing else touches the entry meanwhile: only the GdkPixbuf
+ *      C API is used, since gtkmm wrappers must be created on the main
+ *      thread. Wrap() turns the result into the entry's frames.
+ *
+ *      All frames of an image are scaled into a single atlas pixbuf
+ *      laid out like the source strip, and the entry's frames are
+ *      sub-pixbuf views into it, so an image costs one allocation
+ *      rather than one per frame. If the frames are already the
+ *      target size, the decoded image itself is the atlas.
+ *
+ *      An image that fails to load leaves the entry without frames,
+ *      the same as an icon missing from the theme.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+FrameCache::Decode(Entry *entry) // IN
+{
+   const Key &key = entry->mKey;
+   GError *error = NULL;
+
+   GdkPixbuf *buffer = gdk_pixbuf_new_from_file(key.filename.c_str(), &error);
+   if (!buffer) {
+      g_warning("Unable to load spinner frames from %s: %s",
+                key.filename.c_str(), error->message);
+      g_error_free(error);
+      return;
+   }
+
+   int width = gdk_pixbuf_get_width(buffer);
+   int height = gdk_pixbuf_get_height(buffer);
+   entry->mSourceWidth = width;
+
+   int frameW = key.frameSize;
+   int frameH = key.frameSize;
+   if (key.frameSize <= 0) {
+      frameW = width;
+      frameH = height;
+   }
+
+   int cols = width / frameW;
+   int rows = height / frameH;
+   if (cols == 0 || rows == 0) {
+      g_object_unref(buffer);
+      return;
+   }
+
+   GdkPixbuf *atlas = buffer;
+   if (frameW != key.targetW || frameH != key.targetH) {
+      if (!gdk_pixbuf_get_has_alpha(buffer)) {
+         GdkPixbuf *rgba = gdk_pixbuf_add_alpha(buffer, false, 0, 0, 0);
+         g_object_unref(buffer);
+         buffer = rgba;
+      }
+      atlas = gdk_pixbuf_new(GDK_COLORSPACE_RGB, true, 8,
+                             cols * key.targetW, rows * key.targetH);
+
+      /*
+       * Scale each frame through its own sub-pixbuf so that filtering
+       * clamps at the frame's edges instead of bleeding in pixels from
+       * its neighbours.
+       */
+      for (int row = 0; row < rows; row++) {
+         for (int col = 0; col < cols; col++) {
+            GdkPixbuf *src = gdk_pixbuf_new_subpixbuf(buffer, col * frameW,
+                                                      row * frameH,
+                                                      frameW, frameH);
+            GdkPixbuf *dst = gdk_pixbuf_new_subpixbuf(atlas, col * key.targetW,
+                                                      row * key.targetH,
+                                                      key.targetW,
+                                                      key.targetH);
+            ImageScaler::Scale(src, dst, ImageScaler::FILTER_BILINEAR);
+            g_object_unref(dst);
+            g_object_unref(src);
+         }
+      }
+      g_object_unref(buffer);
+   }
+
+   entry->mAtlas = atlas;
+   entry->mCols = cols;
+   entry->mRows = rows;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::Wrap --
+ *
+ *      Main thread half of a decode: cut the atlas left by Decode()
+ *      into the entry's frames.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+FrameCache::Wrap(Entry *entry) // IN
+{
+   if (!entry->mAtlas) {
+      return;
+   }
+
+   const Key &key = entry->mKey;
+   Glib::RefPtr<Gdk::Pixbuf> atlas = Glib::wrap(entry->mAtlas);
+   entry->mAtlas = NULL;
+
+   for (int row = 0; row < entry->mRows; row++) {
+      for (int col = 0; col < entry->mCols; col++) {
+         entry->mFrames.push_back(
+            Gdk::Pixbuf::create_subpixbuf(atlas, col * key.targetW,
+                                          row * key.targetH,
+                                          key.targetW, key.targetH));
+      }
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::DecodeAsync --
+ *
+ *      Worker pool entry point. Only the entry's key and decode results
+ *      may be touched here; everything else belongs to the main thread.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Wakes the main loop through sDispatcher.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+FrameCache::DecodeAsync(Entry *entry) // IN
+{
+   Decode(entry);
+
+   {
+      Glib::StaticMutex::Lock lock(sMutex);
+      sDone.push_back(entry);
+   }
+   sDispatcher->emit();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FrameCache::OnDecodesDone --
+ *
+ *      Dispatcher handler, run on the main thread. Wrap the frames of
+ *      every entry decoded on the pool, mark it loaded and notify its
+ *      users, or free it if they all went away in the meantime.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Emits loaded signals.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+FrameCache::OnDecodesDone(void)
+{
+   std::vector<Entry *> done;
+   {
+      Glib::StaticMutex::Lock lock(sMutex);
+      done.swap(sDone);
+   }
+
+   for (std::vector<Entry *>::size_type i = 0; i < done.size(); i++) {
+      Entry *entry = done[i];
+      entry->mLoading = false;
+      if (entry->mRefCount == 0) {
+         delete entry;
+         continue;
+      }
+      Wrap(entry);
+      entry->mLoaded = true;
+      entry->loaded.emit();
+   }
+}
+
+
+} // namespace view
@@ -0,0 +1,130 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * frameCache.hh --
+ *
+ *      A process-wide cache of spinner frames. Frames are keyed by the
+ *      image file, its modification time, the size of one frame in the
+ *      file and the size they are scaled to, so every SpinnerAction
+ *      showing the same asset at the same size shares one set of pixbufs
+ *      and an icon theme change decodes each distinct asset at most once.
+ *
+ *      Entries are reference counted and freed when the last user
+ *      releases them. Decoding may happen synchronously or on a worker
+ *      pool; in the latter case the entry's loaded signal is emitted on
+ *      the main thread once its frames are in place.
+ */
+
+#ifndef LIBVIEW_FRAME_CACHE_HH
+#define LIBVIEW_FRAME_CACHE_HH
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <glibmm/dispatcher.h>
+#include <glibmm/thread.h>
+#include <glibmm/threadpool.h>
+#include <gdkmm/pixbuf.h>
+
+
+namespace view {
+
+
+class FrameCache
+{
+public:
+   typedef std::vector<Glib::RefPtr<Gdk::Pixbuf> > FrameVector;
+
+   struct Key
+   {
+      std::string filename;
+      time_t mtime;
+      int frameSize;
+      int targetW;
+      int targetH;
+
+      bool operator<(const Key &other) const;
+   };
+
+   class Entry
+   {
+   public:
+      bool IsLoaded(void) const { return mLoaded; }
+      const FrameVector &GetFrames(void) const { return mFrames; }
+      int GetSourceWidth(void) const { return mSourceWidth; }
+
+      sigc::signal<void> loaded;
+
+   private:
+      friend class FrameCache;
+
+      Entry(const Key &key);
+      ~Entry();
+
+      Key mKey;
+      int mRefCount;
+      bool mLoaded;
+      bool mLoading;
+      FrameVector mFrames;
+      int mSourceWidth;
+
+      // Decoded but not yet wrapped into mFrames; see Wrap().
+      GdkPixbuf *mAtlas;
+      int mCols;
+      int mRows;
+   };
+
+   static Entry *Acquire(const std::string &filename, int frameSize,
+                         int targetW, int targetH);
+   static void Release(Entry *entry);
+
+   static void Load(Entry *entry);
+   static void LoadAsync(Entry *entry);
+
+   static unsigned long GetDecodeCount(void) { return sDecodeCount; }
+
+private:
+   typedef std::map<Key, Entry *> EntryMap;
+
+   static void Decode(Entry *entry);
+   static void Wrap(Entry *entry);
+   static void DecodeAsync(Entry *entry);
+   static void OnDecodesDone(void);
+
+   static EntryMap sEntries;
+   static unsigned long sDecodeCount;
+
+   static Glib::ThreadPool *sPool;
+   static Glib::Dispatcher *sDispatcher;
+   static Glib::StaticMutex sMutex;
+   static std::vector<Entry *> sDone;
+};
+
+
+} // namespace view
+
+
+#endif // LIBVIEW_FRAME_CACHE_HH
@@ -0,0 +1,707 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * imageScaler.cc --
+ *
+ *      Implements the ImageScaler class.
+ *
+ *      Fixed-point layout: filter weights are 14-bit fractions summing to
+ *      exactly 1 << 14. The horizontal pass keeps 7 bits of fraction in
+ *      its 16-bit output (at most 255 << 7, which still fits a signed
+ *      16-bit lane) and the vertical pass rounds away the remaining 21.
+ *      Every product and sum fits in 32 bits, so the SIMD kernels can
+ *      use pmaddwd and match the scalar one exactly.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <libview/imageScaler.hh>
+
+
+#if (defined(__i386__) || defined(__x86_64__)) && \
+    (defined(__clang__) || \
+     (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define VIEW_SCALER_X86 1
+#include <immintrin.h>
+#define VIEW_TARGET_SSE2 __attribute__((target("sse2")))
+#define VIEW_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+#define WEIGHT_BITS 14
+#define MID_BITS 7
+#define H_SHIFT (WEIGHT_BITS - MID_BITS)
+#define V_SHIFT (WEIGHT_BITS + MID_BITS)
+
+
+namespace view {
+
+
+/*
+ * Filter weights for one axis. Every output pixel reads 'taps'
+ * consecutive source pixels starting at start[i], weighted by
+ * weights[i * taps + k].
+ */
+struct ScaleCoeffs
+{
+   int taps;
+   std::vector<int> start;
+   std::vector<gint16> weights;
+};
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * ComputeCoeffs --
+ *
+ *      Compute the weights for scaling srcLen pixels to dstLen.
+ *
+ *      FILTER_BOX averages the source area each output pixel covers.
+ *      FILTER_BILINEAR uses a tent filter that is one pixel wide when
+ *      enlarging and widens with the reduction ratio when shrinking,
+ *      like gdk-pixbuf's GDK_INTERP_BILINEAR.
+ *
+ *      Weights are quantized to WEIGHT_BITS, with the rounding error
+ *      folded into the largest weight so each row sums exactly to 1.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+static void
+ComputeCoeffs(int srcLen,                  // IN
+              int dstLen,                  // IN
+              ImageScaler::Filter filter,  // IN
+              ScaleCoeffs &coeffs)         // OUT
+{
+   double scale = (double)srcLen / dstLen;
+   double support = filter == ImageScaler::FILTER_BOX
+                    ? std::max(scale, 1.0) / 2
+                    : std::max(scale, 1.0);
+
+   int taps = std::min((int)std::ceil(support * 2) + 1, srcLen);
+   coeffs.taps = taps;
+   coeffs.start.resize(dstLen);
+   coeffs.weights.resize(dstLen * taps);
+
+   std::vector<double> w(taps);
+   for (int i = 0; i < dstLen; i++) {
+      double center = (i + 0.5) * scale;
+      int start = (int)std::floor(center - support);
+      start = std::max(0, std::min(start, srcLen - taps));
+      coeffs.start[i] = start;
+
+      double sum = 0;
+      for (int k = 0; k < taps; k++) {
+         int j = start + k;
+         if (filter == ImageScaler::FILTER_BOX) {
+            w[k] = std::min(center + support, j + 1.0)
+                   - std::max(center - support, (double)j);
+         } else {
+            w[k] = 1 - std::fabs(j + 0.5 - center) / support;
+         }
+         w[k] = std::max(w[k], 0.0);
+         sum += w[k];
+      }
+
+      if (sum <= 0) {
+         int nearest = (int)std::floor(center) - start;
+         w[std::max(0, std::min(nearest, taps - 1))] = sum = 1;
+      }
+
+      gint16 *q = &coeffs.weights[i * taps];
+      int total = 0;
+      int largest = 0;
+      for (int k = 0; k < taps; k++) {
+         q[k] = (gint16)std::floor(w[k] / sum * (1 << WEIGHT_BITS) + 0.5);
+         total += q[k];
+         if (q[k] > q[largest]) {
+            largest = k;
+         }
+      }
+      q[largest] += (1 << WEIGHT_BITS) - total;
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * HorizontalScalar --
+ * VerticalScalar --
+ *
+ *      Portable kernels for the two passes. The SIMD kernels fall back
+ *      on these for the pixels left over at the end of a row, so they
+ *      take a range.
+ *
+ *      HorizontalScalar scales source rows [0, rows) into mid;
+ *      VerticalScalar scales mid into destination row y, elements
+ *      [from, n), where n is dstW * 4.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+static void
+HorizontalScalar(const guint8 *src,          // IN
+                 int srcStride,              // IN
+                 int rows,                   // IN
+                 const ScaleCoeffs &coeffs,  // IN
+                 int dstW,                   // IN
+                 guint16 *mid)               // OUT
+{
+   for (int y = 0; y < rows; y++) {
+      const guint8 *row = src + y * srcStride;
+      guint16 *out = mid + y * dstW * 4;
+
+      for (int x = 0; x < dstW; x++) {
+         const gint16 *w = &coeffs.weights[x * coeffs.taps];
+         const guint8 *p = row + coeffs.start[x] * 4;
+         int acc[4] = { 0, 0, 0, 0 };
+
+         for (int k = 0; k < coeffs.taps; k++) {
+            for (int c = 0; c < 4; c++) {
+               acc[c] += w[k] * p[k * 4 + c];
+            }
+         }
+         for (int c = 0; c < 4; c++) {
+            out[x * 4 + c] = (acc[c] + (1 << (H_SHIFT - 1))) >> H_SHIFT;
+         }
+      }
+   }
+}
+
+
+static void
+VerticalScalar(const guint16 *mid,         // IN
+               const ScaleCoeffs &coeffs,  // IN
+               int y,                      // IN
+               int n,                      // IN
+               int from,                   // IN
+               guint8 *out)                // OUT
+{
+   const gint16 *w = &coeffs.weights[y * coeffs.taps];
+   const guint16 *rows = mid + coeffs.start[y] * n;
+
+   for (int i = from; i < n; i++) {
+      int acc = 0;
+      for (int k = 0; k < coeffs.taps; k++) {
+         acc += w[k] * rows[k * n + i];
+      }
+      acc = (acc + (1 << (V_SHIFT - 1))) >> V_SHIFT;
+      out[i] = (guint8)std::max(0, std::min(acc, 255));
+   }
+}
+
+
+#ifdef VIEW_SCALER_X86
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * PairWeights --
+ *
+ *      Pack two 16-bit weights into the 32-bit pattern pmaddwd wants.
+ *
+ * Results:
+ *      The packed weights.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+static inline int
+PairWeights(gint16 w0, // IN
+            gint16 w1) // IN
+{
+   return (int)((guint16)w0 | ((guint32)(guint16)w1 << 16));
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * HorizontalSSE2 --
+ *
+ *      SSE2 horizontal pass. One output pixel at a time, two taps per
+ *      pmaddwd: the taps' channels are interleaved so that each 32-bit
+ *      lane sums one channel of both.
+ *
+ *      There is no AVX2 version; an output pixel only spans a handful
+ *      of taps, so the vertical pass is where the wider registers pay.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+VIEW_TARGET_SSE2 static void
+HorizontalSSE2(const guint8 *src,          // IN
+               int srcStride,              // IN
+               int rows,                   // IN
+               const ScaleCoeffs &coeffs,  // IN
+               int dstW,                   // IN
+               guint16 *mid)               // OUT
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i round = _mm_set1_epi32(1 << (H_SHIFT - 1));
+
+   for (int y = 0; y < rows; y++) {
+      const guint8 *row = src + y * srcStride;
+      guint16 *out = mid + y * dstW * 4;
+
+      for (int x = 0; x < dstW; x++) {
+         const gint16 *w = &coeffs.weights[x * coeffs.taps];
+         const guint8 *p = row + coeffs.start[x] * 4;
+         __m128i acc = zero;
+         int k = 0;
+         gint32 a, b;
+
+         for (; k + 1 < coeffs.taps; k += 2) {
+            memcpy(&a, p + k * 4, 4);
+            memcpy(&b, p + k * 4 + 4, 4);
+            __m128i ab = _mm_unpacklo_epi8(
+               _mm_unpacklo_epi8(_mm_cvtsi32_si128(a), _mm_cvtsi32_si128(b)),
+               zero);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(
+               ab, _mm_set1_epi32(PairWeights(w[k], w[k + 1]))));
+         }
+         if (k < coeffs.taps) {
+            memcpy(&a, p + k * 4, 4);
+            __m128i a0 = _mm_unpacklo_epi8(
+               _mm_unpacklo_epi8(_mm_cvtsi32_si128(a), zero), zero);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(
+               a0, _mm_set1_epi32(PairWeights(w[k], 0))));
+         }
+
+         acc = _mm_srai_epi32(_mm_add_epi32(acc, round), H_SHIFT);
+         _mm_storel_epi64((__m128i *)(out + x * 4), _mm_packs_epi32(acc, acc));
+      }
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * VerticalSSE2 --
+ * VerticalAVX2 --
+ *
+ *      SIMD vertical passes for destination row y from element from:
+ *      8 (SSE2) or 16 (AVX2) channels at a time, two source rows per
+ *      pmaddwd. Each hands what is left to the next narrower kernel.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+VIEW_TARGET_SSE2 static void
+VerticalSSE2(const guint16 *mid,         // IN
+             const ScaleCoeffs &coeffs,  // IN
+             int y,                      // IN
+             int n,                      // IN
+             int from,                   // IN
+             guint8 *out)                // OUT
+{
+   const gint16 *w = &coeffs.weights[y * coeffs.taps];
+   const guint16 *rows = mid + coeffs.start[y] * n;
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i round = _mm_set1_epi32(1 << (V_SHIFT - 1));
+   int i = from;
+
+   for (; i + 8 <= n; i += 8) {
+      __m128i lo = zero;
+      __m128i hi = zero;
+      int k = 0;
+
+      for (; k + 1 < coeffs.taps; k += 2) {
+         __m128i r0 = _mm_loadu_si128((const __m128i *)(rows + k * n + i));
+         __m128i r1 = _mm_loadu_si128((const __m128i *)(rows + (k + 1) * n + i));
+         __m128i ww = _mm_set1_epi32(PairWeights(w[k], w[k + 1]));
+         lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(r0, r1), ww));
+         hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(r0, r1), ww));
+      }
+      if (k < coeffs.taps) {
+         __m128i r0 = _mm_loadu_si128((const __m128i *)(rows + k * n + i));
+         __m128i ww = _mm_set1_epi32(PairWeights(w[k], 0));
+         lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(r0, zero), ww));
+         hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(r0, zero), ww));
+      }
+
+      lo = _mm_srai_epi32(_mm_add_epi32(lo, round), V_SHIFT);
+      hi = _mm_srai_epi32(_mm_add_epi32(hi, round), V_SHIFT);
+      __m128i words = _mm_packs_epi32(lo, hi);
+      _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(words, words));
+   }
+
+   VerticalScalar(mid, coeffs, y, n, i, out);
+}
+
+
+VIEW_TARGET_AVX2 static void
+VerticalAVX2(const guint16 *mid,         // IN
+             const ScaleCoeffs &coeffs,  // IN
+             int y,                      // IN
+             int n,                      // IN
+             guint8 *out)                // OUT
+{
+   const gint16 *w = &coeffs.weights[y * coeffs.taps];
+   const guint16 *rows = mid + coeffs.start[y] * n;
+   const __m256i zero = _mm256_setzero_si256();
+   const __m256i round = _mm256_set1_epi32(1 << (V_SHIFT - 1));
+   int i = 0;
+
+   for (; i + 16 <= n; i += 16) {
+      __m256i lo = zero;
+      __m256i hi = zero;
+      int k = 0;
+
+      /*
+       * unpacklo/hi and packs work within each 128-bit lane, so the
+       * channels come back out of packs_epi32 in their original order.
+       */
+      for (; k + 1 < coeffs.taps; k += 2) {
+         __m256i r0 = _mm256_loadu_si256((const __m256i *)(rows + k * n + i));
+         __m256i r1 = _mm256_loadu_si256((const __m256i *)(rows + (k + 1) * n + i));
+         __m256i ww = _mm256_set1_epi32(PairWeights(w[k], w[k + 1]));
+         lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(r0, r1), ww));
+         hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(r0, r1), ww));
+      }
+      if (k < coeffs.taps) {
+         __m256i r0 = _mm256_loadu_si256((const __m256i *)(rows + k * n + i));
+         __m256i ww = _mm256_set1_epi32(PairWeights(w[k], 0));
+         lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(r0, zero), ww));
+         hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(r0, zero), ww));
+      }
+
+      lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), V_SHIFT);
+      hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), V_SHIFT);
+      __m256i words = _mm256_packs_epi32(lo, hi);
+      __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words),
+                                               0x08);
+      _mm_storeu_si128((__m128i *)(out + i), _mm256_castsi256_si128(bytes));
+   }
+
+   VerticalSSE2(mid, coeffs, y, n, i, out);
+}
+
+#endif // VIEW_SCALER_X86
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ImageScaler::IsKernelSupported --
+ *
+ *      Whether this build and CPU can run a kernel.
+ *
+ * Results:
+ *      true if kernel can be used.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+ImageScaler::IsKernelSupported(Kernel kernel) // IN
+{
+   switch (kernel) {
+   case KERNEL_AUTO:
+   case KERNEL_SCALAR:
+      return true;
+#ifdef VIEW_SCALER_X86
+   case KERNEL_SSE2:
+      return __builtin_cpu_supports("sse2");
+   case KERNEL_AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+   default:
+      return false;
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ImageScaler::GetBestKernel --
+ *
+ *      Pick the fastest kernel this CPU supports.
+ *
+ * Results:
+ *      The kernel KERNEL_AUTO stands for.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+ImageScaler::Kernel
+ImageScaler::GetBestKernel(void)
+{
+   if (IsKernelSupported(KERNEL_AVX2)) {
+      return KERNEL_AVX2;
+   }
+   if (IsKernelSupported(KERNEL_SSE2)) {
+      return KERNEL_SSE2;
+   }
+   return KERNEL_SCALAR;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ImageScaler::Scale --
+ *
+ *      Scale a premultiplied or opaque RGBA image, 8 bits per channel,
+ *      into dst. Overlapping src and dst are not supported.
+ *
+ *      An unsupported kernel falls back to the scalar one.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ImageScaler::Scale(const guint8 *src, // IN
+                   int srcW,          // IN
+                   int srcH,          // IN
+                   int srcStride,     // IN
+                   guint8 *dst,       // OUT
+                   int dstW,          // IN
+                   int dstH,          // IN
+                   int dstStride,     // IN
+                   Filter filter,     // IN
+                   Kernel kernel)     // IN
+{
+   if (srcW <= 0 || srcH <= 0 || dstW <= 0 || dstH <= 0) {
+      return;
+   }
+
+   if (kernel == KERNEL_AUTO) {
+      kernel = GetBestKernel();
+   } else if (!IsKernelSupported(kernel)) {
+      kernel = KERNEL_SCALAR;
+   }
+
+   ScaleCoeffs xCoeffs;
+   ScaleCoeffs yCoeffs;
+   ComputeCoeffs(srcW, dstW, filter, xCoeffs);
+   ComputeCoeffs(srcH, dstH, filter, yCoeffs);
+
+   int n = dstW * 4;
+   std::vector<guint16> mid(srcH * n);
+
+   switch (kernel) {
+#ifdef VIEW_SCALER_X86
+   case KERNEL_SSE2:
+      HorizontalSSE2(src, srcStride, srcH, xCoeffs, dstW, &mid[0]);
+      for (int y = 0; y < dstH; y++) {
+         VerticalSSE2(&mid[0], yCoeffs, y, n, 0, dst + y * dstStride);
+      }
+      break;
+   case KERNEL_AVX2:
+      HorizontalSSE2(src, srcStride, srcH, xCoeffs, dstW, &mid[0]);
+      for (int y = 0; y < dstH; y++) {
+         VerticalAVX2(&mid[0], yCoeffs, y, n, dst + y * dstStride);
+      }
+      break;
+#endif
+   default:
+      HorizontalScalar(src, srcStride, srcH, xCoeffs, dstW, &mid[0]);
+      for (int y = 0; y < dstH; y++) {
+         VerticalScalar(&mid[0], yCoeffs, y, n, 0, dst + y * dstStride);
+      }
+      break;
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ImageScaler::Scale --
+ *
+ *      Scale src to fill dst. Both must be 8-bit RGBA pixbufs; dst may
+ *      be a sub-pixbuf view into a larger one.
+ *
+ *      The GdkPixbuf overload creates no gtkmm wrappers, so it can be
+ *      used off the main thread.
+ *
+ *      Pixbufs store unassociated alpha, which would let the colour of
+ *      transparent pixels bleed into their neighbours, so the source is
+ *      premultiplied into a scratch copy first and dst is divided back
+ *      afterwards. The alpha channel is checked first, so fully opaque
+ *      sources skip both steps and never allocate the copy.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ImageScaler::Scale(const Glib::RefPtr<Gdk::Pixbuf> &src, // IN
+                   const Glib::RefPtr<Gdk::Pixbuf> &dst, // IN
+                   Filter filter)                        // IN
+{
+   Scale(src->gobj(), dst->gobj(), filter);
+}
+
+
+void
+ImageScaler::Scale(GdkPixbuf *src, // IN
+                   GdkPixbuf *dst, // IN
+                   Filter filter)  // IN
+{
+   g_return_if_fail(gdk_pixbuf_get_n_channels(src) == 4 &&
+                    gdk_pixbuf_get_bits_per_sample(src) == 8);
+   g_return_if_fail(gdk_pixbuf_get_n_channels(dst) == 4 &&
+                    gdk_pixbuf_get_bits_per_sample(dst) == 8);
+
+   int srcW = gdk_pixbuf_get_width(src);
+   int srcH = gdk_pixbuf_get_height(src);
+   int dstW = gdk_pixbuf_get_width(dst);
+   int dstH = gdk_pixbuf_get_height(dst);
+   const guint8 *srcPixels = gdk_pixbuf_get_pixels(src);
+   int srcStride = gdk_pixbuf_get_rowstride(src);
+
+   bool opaque = true;
+   for (int y = 0; y < srcH && opaque; y++) {
+      const guint8 *in = srcPixels + y * srcStride;
+      for (int x = 0; x < srcW * 4; x += 4) {
+         if (in[x + 3] != 255) {
+            opaque = false;
+            break;
+         }
+      }
+   }
+
+   std::vector<guint8> premultiplied;
+   if (!opaque) {
+      premultiplied.resize(srcW * srcH * 4);
+      for (int y = 0; y < srcH; y++) {
+         const guint8 *in = srcPixels + y * srcStride;
+         guint8 *out = &premultiplied[y * srcW * 4];
+         for (int x = 0; x < srcW * 4; x += 4) {
+            unsigned int a = in[x + 3];
+            for (int c = 0; c < 3; c++) {
+               out[x + c] = (in[x + c] * a + 127) / 255;
+            }
+            out[x + 3] = a;
+         }
+      }
+      srcPixels = &premultiplied[0];
+      srcStride = srcW * 4;
+   }
+
+   guint8 *dstPixels = gdk_pixbuf_get_pixels(dst);
+   int dstStride = gdk_pixbuf_get_rowstride(dst);
+   Scale(srcPixels, srcW, srcH, srcStride, dstPixels, dstW, dstH, dstStride,
+         filter);
+
+   if (!opaque) {
+      for (int y = 0; y < dstH; y++) {
+         guint8 *p = dstPixels + y * dstStride;
+         for (int x = 0; x < dstW * 4; x += 4) {
+            unsigned int a = p[x + 3];
+            for (int c = 0; c < 3; c++) {
+               p[x + c] = a ? std::min(255u, (p[x + c] * 255 + a / 2) / a) : 0;
+            }
+         }
+      }
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ImageScaler::ScaleSimple --
+ *
+ *      Counterpart of Gdk::Pixbuf::scale_simple().
+ *
+ * Results:
+ *      A new RGBA pixbuf of the given size.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+Glib::RefPtr<Gdk::Pixbuf>
+ImageScaler::ScaleSimple(const Glib::RefPtr<Gdk::Pixbuf> &src, // IN
+                         int width,                            // IN
+                         int height,                           // IN
+                         Filter filter)                        // IN
+{
+   Glib::RefPtr<Gdk::Pixbuf> rgba = src->get_has_alpha()
+                                    ? src : src->add_alpha(false, 0, 0, 0);
+   Glib::RefPtr<Gdk::Pixbuf> dst =
+      Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, true, 8, width, height);
+   Scale(rgba, dst, filter);
+   return dst;
+}
+
+
+} // namespace view
@@ -0,0 +1,86 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * imageScaler.hh --
+ *
+ *      Fast RGBA image scaling for icons and spinner frames.
+ *
+ *      Scaling is separable: a horizontal pass into a 16-bit intermediate
+ *      buffer, then a vertical pass back to 8 bits, both with fixed-point
+ *      weights. Besides the portable kernel there are SSE2 and AVX2 ones,
+ *      picked at runtime from what the CPU supports. All kernels do the
+ *      same integer arithmetic, so they produce identical pixels.
+ *
+ *      The raw interface works on premultiplied (or opaque) RGBA. The
+ *      Gdk::Pixbuf interface takes care of premultiplying, since pixbufs
+ *      store unassociated alpha.
+ */
+
+#ifndef LIBVIEW_IMAGE_SCALER_HH
+#define LIBVIEW_IMAGE_SCALER_HH
+
+
+#include <gdkmm/pixbuf.h>
+
+
+namespace view {
+
+
+class ImageScaler
+{
+public:
+   enum Filter {
+      FILTER_BOX,
+      FILTER_BILINEAR
+   };
+
+   enum Kernel {
+      KERNEL_AUTO,
+      KERNEL_SCALAR,
+      KERNEL_SSE2,
+      KERNEL_AVX2
+   };
+
+   static void Scale(const guint8 *src, int srcW, int srcH, int srcStride,
+                     guint8 *dst, int dstW, int dstH, int dstStride,
+                     Filter filter, Kernel kernel = KERNEL_AUTO);
+
+   static void Scale(const Glib::RefPtr<Gdk::Pixbuf> &src,
+                     const Glib::RefPtr<Gdk::Pixbuf> &dst,
+                     Filter filter = FILTER_BILINEAR);
+   static void Scale(GdkPixbuf *src, GdkPixbuf *dst,
+                     Filter filter = FILTER_BILINEAR);
+   static Glib::RefPtr<Gdk::Pixbuf> ScaleSimple(const Glib::RefPtr<Gdk::Pixbuf> &src,
+                                                int width, int height,
+                                                Filter filter = FILTER_BILINEAR);
+
+   static bool IsKernelSupported(Kernel kernel);
+   static Kernel GetBestKernel(void);
+};
+
+
+} // namespace view
+
+
+#endif // LIBVIEW_IMAGE_SCALER_HH
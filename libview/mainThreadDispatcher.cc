@@ -0,0 +1,454 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * mainThreadDispatcher.cc --
+ *
+ *      Updates to libview widgets posted from worker threads and applied
+ *      on the main thread.
+ */
+
+
+#include <libview/fieldEntry.hh>
+#include <libview/mainThreadDispatcher.hh>
+#include <libview/spinnerAction.hh>
+#include <libview/wrapLabel.hh>
+
+
+namespace view {
+
+
+/*
+ * Queued updates, newest first. Worker threads push onto it with a compare
+ * and exchange; the main thread takes the whole queue at once, so there
+ * is no ABA problem.
+ */
+gpointer volatile MainThreadDispatcher::sQueue = NULL;
+volatile gint MainThreadDispatcher::sWakePending = 0;
+
+/* Updates taken from the queue and waiting to be applied, oldest first. */
+MainThreadDispatcher::Update *MainThreadDispatcher::sBatch = NULL;
+MainThreadDispatcher::Update *MainThreadDispatcher::sBatchTail = NULL;
+
+Glib::Dispatcher *MainThreadDispatcher::sDispatcher = NULL;
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MainThreadDispatcher::Update::Update --
+ *
+ *      Constructor. Must be called on the main thread; the first update
+ *      created sets up the dispatcher there.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      May initialize threads.
+ *
+ *-------------------------------------------------------------------
+ */
+
+MainThreadDispatcher::Update::Update(void)
+   : mNext(NULL),
+     mQueued(0)
+{
+   if (!sDispatcher) {
+#if !GLIB_CHECK_VERSION(2, 32, 0)
+      if (!Glib::thread_supported()) {
+         Glib::thread_init();
+      }
+#endif
+      sDispatcher = new Glib::Dispatcher();
+      sDispatcher->connect(sigc::ptr_fun(&MainThreadDispatcher::Flush));
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MainThreadDispatcher::Update::~Update --
+ *
+ *      Destructor. Must be called on the main thread, once no thread is
+ *      still inside Set() or Fire() on this update. A queued update is
+ *      taken out of the queue without being applied.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+MainThreadDispatcher::Update::~Update()
+{
+   if (g_atomic_int_get(&mQueued)) {
+      MainThreadDispatcher::Cancel(this);
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MainThreadDispatcher::Update::Queue --
+ *
+ *      Have the update applied on the main thread, unless it is already
+ *      queued. May be called from any thread.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      May wake the main loop.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MainThreadDispatcher::Update::Queue(void)
+{
+   if (g_atomic_int_compare_and_exchange(&mQueued, 0, 1)) {
+      MainThreadDispatcher::Push(this);
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MainThreadDispatcher::Update::Exchange --
+ *
+ *      Atomically replace a pointer.
+ *
+ * Results:
+ *      The previous value.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+gpointer
+MainThreadDispatcher::Update::Exchange(gpointer volatile *atomic, // IN/OUT
+                                       gpointer value)            // IN
+{
+   gpointer old;
+
+   do {
+      old = g_atomic_pointer_get(atomic);
+   } while (!g_atomic_pointer_compare_and_exchange(atomic, old, value));
+
+   return old;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MainThreadDispatcher::Trigger::Trigger --
+ *
+ *      Constructor.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+MainThreadDispatcher::Trigger::Trigger(const sigc::slot<void> &slot) // IN
+   : mSlot(slot)
+{
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MainThreadDispatcher::Trigger::Apply --
+ *
+ *      Call the trigger's slot.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Those of the slot.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MainThreadDispatcher::Trigger::Apply(void)
+{
+   mSlot();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MainThreadDispatcher::Flush --
+ *
+ *      Apply every queued update, in the order they were first queued.
+ *      Called on the main thread when the dispatcher wakes it, and may
+ *      also be called there directly.
+ *
+ *      Updates are taken off the batch one at a time, so that one being
+ *      applied may destroy others.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Those of the updates.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MainThreadDispatcher::Flush(void)
+{
+   /*
+    * Clear the flag before taking the queue, so that a post racing with
+    * us wakes the main loop again rather than being left behind.
+    */
+   g_atomic_int_set(&sWakePending, 0);
+   TakeQueue();
+
+   while (sBatch) {
+      Update *update = sBatch;
+      sBatch = update->mNext;
+      if (!sBatch) {
+         sBatchTail = NULL;
+      }
+      update->mNext = NULL;
+
+      // Posts from here on queue the update again.
+      g_atomic_int_set(&update->mQueued, 0);
+      update->Apply();
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MainThreadDispatcher::Push --
+ *
+ *      Push an update onto the queue. May be called from any thread.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Wakes the main loop if nothing else has since it last flushed.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MainThreadDispatcher::Push(Update *update) // IN
+{
+   gpointer head;
+
+   do {
+      head = g_atomic_pointer_get(&sQueue);
+      update->mNext = static_cast<Update *>(head);
+   } while (!g_atomic_pointer_compare_and_exchange(&sQueue, head, update));
+
+   if (g_atomic_int_compare_and_exchange(&sWakePending, 0, 1)) {
+      sDispatcher->emit();
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MainThreadDispatcher::TakeQueue --
+ *
+ *      Take everything off the queue and append it, oldest first, to the
+ *      batch waiting to be applied. Main thread only.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MainThreadDispatcher::TakeQueue(void)
+{
+   gpointer head;
+
+   do {
+      head = g_atomic_pointer_get(&sQueue);
+   } while (head && !g_atomic_pointer_compare_and_exchange(&sQueue, head, NULL));
+
+   if (!head) {
+      return;
+   }
+
+   Update *newest = static_cast<Update *>(head);
+   Update *oldest = NULL;
+   Update *update = newest;
+   while (update) {
+      Update *next = update->mNext;
+      update->mNext = oldest;
+      oldest = update;
+      update = next;
+   }
+
+   if (sBatchTail) {
+      sBatchTail->mNext = oldest;
+   } else {
+      sBatch = oldest;
+   }
+   sBatchTail = newest;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MainThreadDispatcher::Cancel --
+ *
+ *      Take a queued update out without applying it. A lock-free queue
+ *      can't be unlinked from, so the queue is moved to the batch first;
+ *      the rest of it is still applied at the next flush. Main thread
+ *      only.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MainThreadDispatcher::Cancel(Update *update) // IN
+{
+   TakeQueue();
+
+   Update *prev = NULL;
+   for (Update *i = sBatch; i; prev = i, i = i->mNext) {
+      if (i == update) {
+         if (prev) {
+            prev->mNext = i->mNext;
+         } else {
+            sBatch = i->mNext;
+         }
+         if (sBatchTail == i) {
+            sBatchTail = prev;
+         }
+         break;
+      }
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::SpinnerAdvance::SpinnerAdvance --
+ *
+ *      Constructor. Firing the update advances the action's spinners by
+ *      one frame, however many times it was fired since the last dispatch.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+SpinnerAdvance::SpinnerAdvance(SpinnerAction &action) // IN
+   : MainThreadDispatcher::Trigger(
+        sigc::mem_fun(action, &SpinnerAction::Advance))
+{
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::WrapLabelText::WrapLabelText --
+ *
+ *      Constructor. Setting the update sets the label's text.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+WrapLabelText::WrapLabelText(WrapLabel &label) // IN
+   : MainThreadDispatcher::Property<Glib::ustring>(
+        sigc::mem_fun(label, &WrapLabel::set_text))
+{
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::FieldEntryText::FieldEntryText --
+ *
+ *      Constructor. Setting the update sets the entry's text.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+FieldEntryText::FieldEntryText(FieldEntry &entry) // IN
+   : MainThreadDispatcher::Property<Glib::ustring>(
+        sigc::mem_fun(entry, &FieldEntry::SetText))
+{
+}
+
+
+} // namespace view
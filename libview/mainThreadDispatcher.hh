@@ -0,0 +1,184 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * mainThreadDispatcher.hh --
+ *
+ *      Updates to libview widgets posted from worker threads and applied
+ *      on the main thread.
+ *
+ *      Each Update stands for one property of one target, e.g. the text
+ *      of a label, and is created on the main thread. Worker threads then
+ *      post new values to it as often as they like. Posting never blocks:
+ *      a queued update sits on a lock-free multiple-producer queue, and
+ *      posting to an update that is already queued only replaces its value,
+ *      so a burst of posts is applied once, with the latest value. The
+ *      main loop is woken at most once per dispatch, however many updates
+ *      are queued.
+ *
+ *      An Update must outlive its posters: every thread posting to it
+ *      must have returned from Set() or Fire() before it is destroyed.
+ *      Destroying a queued update takes it off the queue, but nothing
+ *      stops a post that is still running.
+ */
+
+#ifndef LIBVIEW_MAIN_THREAD_DISPATCHER_HH
+#define LIBVIEW_MAIN_THREAD_DISPATCHER_HH
+
+
+#include <glibmm/dispatcher.h>
+#include <glibmm/thread.h>
+#include <glibmm/ustring.h>
+
+
+namespace view {
+
+
+class FieldEntry;
+class SpinnerAction;
+class WrapLabel;
+
+
+class MainThreadDispatcher
+{
+public:
+   class Update
+   {
+   public:
+      virtual ~Update();
+
+   protected:
+      Update(void);
+
+      void Queue(void);
+      virtual void Apply(void) = 0;
+
+      static gpointer Exchange(gpointer volatile *atomic, gpointer value);
+
+   private:
+      friend class MainThreadDispatcher;
+
+      // Queued updates are linked through themselves, so no copies.
+      Update(const Update &);
+      Update &operator=(const Update &);
+
+      Update *mNext;
+      volatile gint mQueued;
+   };
+
+   // Calls a slot once per dispatch, however many times it was fired.
+   class Trigger
+      : public Update
+   {
+   public:
+      Trigger(const sigc::slot<void> &slot);
+
+      void Fire(void) { Queue(); }
+
+   protected:
+      void Apply(void);
+
+   private:
+      sigc::slot<void> mSlot;
+   };
+
+   // Passes the latest value set to a setter slot.
+   template <typename T>
+   class Property
+      : public Update
+   {
+   public:
+      typedef sigc::slot<void, const T &> Setter;
+
+      Property(const Setter &setter) : mSetter(setter), mPending(NULL) {}
+      ~Property() { delete static_cast<T *>(Exchange(&mPending, NULL)); }
+
+      void Set(const T &value)
+      {
+         delete static_cast<T *>(Exchange(&mPending, new T(value)));
+         Queue();
+      }
+
+   protected:
+      void Apply(void)
+      {
+         T *value = static_cast<T *>(Exchange(&mPending, NULL));
+         if (value) {
+            mSetter(*value);
+            delete value;
+         }
+      }
+
+   private:
+      Setter mSetter;
+      gpointer volatile mPending;
+   };
+
+   static void Flush(void);
+
+private:
+   static void Push(Update *update);
+   static void TakeQueue(void);
+   static void Cancel(Update *update);
+
+   static gpointer volatile sQueue;
+   static volatile gint sWakePending;
+   static Update *sBatch;
+   static Update *sBatchTail;
+   static Glib::Dispatcher *sDispatcher;
+};
+
+
+/*
+ * Ready-made updates. They don't keep their targets alive, and do nothing
+ * once the target is gone.
+ */
+
+class SpinnerAdvance
+   : public MainThreadDispatcher::Trigger
+{
+public:
+   SpinnerAdvance(SpinnerAction &action);
+};
+
+
+class WrapLabelText
+   : public MainThreadDispatcher::Property<Glib::ustring>
+{
+public:
+   WrapLabelText(WrapLabel &label);
+};
+
+
+class FieldEntryText
+   : public MainThreadDispatcher::Property<Glib::ustring>
+{
+public:
+   FieldEntryText(FieldEntry &entry);
+};
+
+
+} // namespace view
+
+
+#endif // LIBVIEW_MAIN_THREAD_DISPATCHER_HH
@@ -28,12 +28,20 @@
  */
 
 
-#include <gtkmm/toggletoolbutton.h>
 #include <gtk/gtkmenu.h>
 
 #include <libview/menuToggleAction.hh>
 
 
+/*
+ * Tool button proxies point back at their action through this key, so that
+ * the button press handler needs no per-proxy state in the action and goes
+ * inert once the proxy is disconnected.
+ */
+#define MENU_TOGGLE_ACTION_KEY "libview-menu-toggle-action"
+#define MENU_TOGGLE_HANDLER_KEY "libview-menu-toggle-handler"
+
+
 namespace view {
 
 
@@ -58,9 +66,13 @@ MenuToggleAction::MenuToggleAction(const Glib::ustring &name,    // IN
                                    const Glib::ustring &label,   // IN
                                    const Glib::ustring &tooltip, // IN
                                    bool isActive,                // IN
-                                   Gtk::Menu *menu)              // IN
+                                   Gtk::Menu *menu,              // IN/OPT
+                                   const MenuFactory &menuFactory) // IN/OPT
    : Gtk::ToggleAction(name, stockID, label, tooltip, isActive),
-     mMenu(menu)
+     mMenu(menu),
+     mMenuFactory(menuFactory),
+     mAttachWidget(NULL),
+     mAttachDestroyId(0)
 {
 }
 
@@ -83,7 +95,10 @@ MenuToggleAction::MenuToggleAction(const Glib::ustring &name,    // IN
 
 MenuToggleAction::~MenuToggleAction()
 {
-   delete mMenu;
+   if (mMenu) {
+      DetachMenu();
+      delete mMenu;
+   }
 }
 
 
@@ -92,8 +107,9 @@ MenuToggleAction::~MenuToggleAction()
  *
  * view::MenuToggleAction::create --
  *
- *      Public named constructor. Required by the Glib::RefPtr
- *      pattern.
+ *      Public named constructors. Required by the Glib::RefPtr
+ *      pattern. The menu is either given or built by menuFactory
+ *      when first needed.
  *
  * Results:
  *      Glib::RefPtr to the new instance.
@@ -117,14 +133,90 @@ MenuToggleAction::create(const Glib::ustring &name,    // IN
 }
 
 
+Glib::RefPtr<MenuToggleAction>
+MenuToggleAction::create(const Glib::ustring &name,       // IN
+                         const Gtk::StockID &stockID,     // IN
+                         const Glib::ustring &label,      // IN
+                         const Glib::ustring &tooltip,    // IN
+                         bool isActive,                   // IN
+                         const MenuFactory &menuFactory)  // IN
+{
+   return Glib::RefPtr<MenuToggleAction>(
+      new MenuToggleAction(name, stockID, label, tooltip, isActive, NULL,
+                           menuFactory));
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MenuToggleAction::GetMenu --
+ *
+ *      Get the action's menu, building it first if need be.
+ *
+ * Results:
+ *      The menu, or NULL if the action has none.
+ *
+ * Side effects:
+ *      May call the menu factory.
+ *
+ *-------------------------------------------------------------------
+ */
+
+Gtk::Menu *
+MenuToggleAction::GetMenu(void)
+{
+   if (!mMenu && mMenuFactory) {
+      mMenu = mMenuFactory();
+   }
+   return mMenu;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MenuToggleAction::ReleaseMenu --
+ *
+ *      Destroy a factory-built menu to free its memory, e.g. under
+ *      memory pressure. It is built again the next time it is needed.
+ *      A menu that was given to the action, or that is popped up, is
+ *      kept.
+ *
+ * Results:
+ *      true if the menu was released.
+ *
+ * Side effects:
+ *      A menu item proxy holding the menu gets a stand-in again.
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+MenuToggleAction::ReleaseMenu(void)
+{
+   if (!mMenu || !mMenuFactory || mMenu->is_mapped()) {
+      return false;
+   }
+
+   DetachMenu();
+   delete mMenu;
+   mMenu = NULL;
+   return true;
+}
+
+
 /*
  *-------------------------------------------------------------------
  *
  * view::MenuToggleAction::create_menu_item_vfunc --
  *
- *      Virtual method override to create a submenu if the action
- *      was passed a menu, or just create a regular check menu
- *      item if not.
+ *      Virtual method override to create a submenu item if the action
+ *      has a menu, or just create a regular check menu item if not.
+ *
+ *      The item starts out with an empty stand-in submenu, so that it
+ *      looks like a submenu item without the menu being built. It takes
+ *      the real menu over when it is selected.
  *
  * Results:
  *      Menu item.
@@ -138,9 +230,12 @@ MenuToggleAction::create(const Glib::ustring &name,    // IN
 Gtk::Widget *
 MenuToggleAction::create_menu_item_vfunc(void)
 {
-   if (mMenu) {
+   if (mMenu || mMenuFactory) {
       Gtk::MenuItem *item = new Gtk::MenuItem();
-      item->set_submenu(*mMenu);
+      item->set_submenu(*Gtk::manage(new Gtk::Menu()));
+      item->signal_select().connect(
+         sigc::bind(sigc::mem_fun(this, &MenuToggleAction::OnItemSelected), item),
+         false);
       return item;
    } else {
       return Gtk::ToggleAction::create_menu_item_vfunc();
@@ -157,6 +252,10 @@ MenuToggleAction::create_menu_item_vfunc(void)
  *      action. Menu items are treated as normal, while buttons have
  *      a mouse press handler attached to show a context menu.
  *
+ *      The handler is connected once per button and finds the action
+ *      through the button's data, so reconnecting a button to an
+ *      action doesn't stack handlers.
+ *
  * Results:
  *      None
  *
@@ -171,10 +270,15 @@ MenuToggleAction::connect_proxy_vfunc(Gtk::Widget *widget) // IN
 {
    Gtk::ToggleToolButton *toolButton = dynamic_cast<Gtk::ToggleToolButton *>(widget);
    if (toolButton) {
-      widgetMap[widget] =
+      GObject *object = G_OBJECT(toolButton->gobj());
+      if (!g_object_get_data(object, MENU_TOGGLE_HANDLER_KEY)) {
          toolButton->get_child()->signal_button_press_event().connect(
-            sigc::bind(sigc::mem_fun(this, &MenuToggleAction::OnButtonPressed), widget),
+            sigc::bind(sigc::ptr_fun(&MenuToggleAction::OnButtonPressed),
+                       toolButton),
             false);
+         g_object_set_data(object, MENU_TOGGLE_HANDLER_KEY, GINT_TO_POINTER(1));
+      }
+      g_object_set_data(object, MENU_TOGGLE_ACTION_KEY, this);
    }
 
    /*
@@ -204,6 +308,7 @@ MenuToggleAction::connect_proxy_vfunc(Gtk::Widget *widget) // IN
  *
  * Side effects:
  *      Side effects of Gtk::ToggleAction::disconnect_proxy_vfunc.
+ *      The menu is detached if it was attached to the proxy.
  *
  *-------------------------------------------------------------------
  */
@@ -213,10 +318,11 @@ MenuToggleAction::disconnect_proxy_vfunc(Gtk::Widget *widget) // IN
 {
    Gtk::ToggleToolButton *toolButton = dynamic_cast<Gtk::ToggleToolButton *>(widget);
    if (toolButton) {
-      g_assert(widgetMap.find(toolButton->get_child()) != widgetMap.end());
-
-      widgetMap[widget].disconnect();
-      widgetMap.erase(widget);
+      g_object_set_data(G_OBJECT(toolButton->gobj()), MENU_TOGGLE_ACTION_KEY,
+                        NULL);
+   }
+   if (mMenu && mMenu->get_attach_widget() == widget) {
+      DetachMenu();
    }
    Gtk::ToggleAction::disconnect_proxy_vfunc(widget);
 }
@@ -230,77 +336,186 @@ MenuToggleAction::disconnect_proxy_vfunc(Gtk::Widget *widget) // IN
  *      Callback for when a button press event is received by a
  *      tool button proxy. Shows a context menu on right click.
  *
+ *      It is generally desirable to associate a popup menu with the
+ *      widget that invoked it, so if the menu isn't attached to
+ *      anything, it is attached to this button and stays attached
+ *      until the button stops being a proxy or is destroyed, or another
+ *      proxy takes the menu over. Otherwise it is popped up where it is.
+ *
  * Results:
- *      true if menu was shown (event handled), false if not.
+ *      true if the event was a right click on a connected proxy, false
+ *      if not.
  *
  * Side effects:
- *      None
+ *      May build the menu.
  *
  *-------------------------------------------------------------------
  */
 
 bool
-MenuToggleAction::OnButtonPressed(GdkEventButton *event, // IN
-                                  Gtk::Widget *widget)   // IN
+MenuToggleAction::OnButtonPressed(GdkEventButton *event,             // IN
+                                  Gtk::ToggleToolButton *toolButton) // IN
 {
-   if (event->button == 3) {
-      if (mMenu) {
-         /*
-          * It is generally desirable to associate a popupmenu with the
-          * widget that invoked it, so we attempt to do so. However,
-          * the GtkMenu model is illsuited to our case where we have
-          * one menu and many widgets so we must try and make do. We assume
-          * that if the menu already has an attach widget, we should let
-          * things be. That attach_widget will be some proxy, and that's
-          * as good as any other.
-          */
-         if (!mMenu->get_attach_widget()) {
-            gtk_menu_attach_to_widget(mMenu->gobj(),
-                                      widget->gobj(),
-                                      MenuToggleAction::OnMenuDetached);
-            /*
-             * The standard pattern is to leave the widget attached and let
-             * the menu disconnect itself in its finalize method. However, in
-             * our case, the menu has a longer lifetime than the widget and
-             * GtkMenu does not track the widget, so there are problems when
-             * the menu finally goes away. To avoid this, we explicitly
-             * disconnect, once the menu is dismissed.
-             */
-            mDetachConnection = mMenu->signal_unmap().connect(
-               sigc::mem_fun(this, &MenuToggleAction::DetachFromMenu));
-
-         }
-         mMenu->popup(event->button, event->time);
-      }      
-      return true;
-   } else {
+   MenuToggleAction *action = static_cast<MenuToggleAction *>(
+      g_object_get_data(G_OBJECT(toolButton->gobj()), MENU_TOGGLE_ACTION_KEY));
+   if (!action || event->button != 3) {
       return false;
    }
+
+   Gtk::Menu *menu = action->GetMenu();
+   if (menu) {
+      if (!menu->get_attach_widget()) {
+         action->AttachMenu(toolButton);
+      }
+      menu->popup(event->button, event->time);
+   }
+   return true;
 }
 
 
 /*
  *-------------------------------------------------------------------
  *
- * view::MenuToggleAction::DetachFromMenu --
+ * view::MenuToggleAction::OnItemSelected --
  *
- *      Callback to detach from the action's menu that disconnects
- *      itself as well.
+ *      Handler for "select" on a menu item proxy, run before the item
+ *      pops up its submenu. Moves the menu onto this item, replacing
+ *      its stand-in, unless it is already there.
  *
  * Results:
  *      None
  *
  * Side effects:
+ *      May build the menu.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MenuToggleAction::OnItemSelected(Gtk::MenuItem *item) // IN
+{
+   Gtk::Menu *menu = GetMenu();
+   if (!menu || item->get_submenu() == menu) {
+      return;
+   }
+
+   DetachMenu();
+   AttachMenu(item);
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MenuToggleAction::AttachMenu --
+ *
+ *      Attach the menu to a proxy, as the submenu of a menu item or as
+ *      the popup of a tool button, and watch the proxy so that the menu
+ *      is detached before the proxy goes away.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MenuToggleAction::AttachMenu(Gtk::Widget *widget) // IN
+{
+   Gtk::MenuItem *item = dynamic_cast<Gtk::MenuItem *>(widget);
+   if (item) {
+      item->set_submenu(*mMenu);
+   } else {
+      gtk_menu_attach_to_widget(mMenu->gobj(), widget->gobj(),
+                                MenuToggleAction::OnMenuDetached);
+   }
+
+   mAttachWidget = widget->gobj();
+   mAttachDestroyId = g_signal_connect(mAttachWidget, "destroy",
+                                       G_CALLBACK(OnAttachWidgetDestroyed),
+                                       this);
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MenuToggleAction::OnAttachWidgetDestroyed --
+ *
+ *      "destroy" handler for the proxy the menu is attached to. The
+ *      UIManager destroys proxies without disconnecting them from the
+ *      action, so this is where the menu lets go of the proxy.
+ *
+ *      Handlers run before the class handler, and a menu item's class
+ *      handler destroys its submenu, so the menu has to be taken back
+ *      here. The proxy's C++ wrapper may already be going away, so this
+ *      sticks to the C API.
+ *
+ * Results:
  *      None
  *
+ * Side effects:
+ *      The menu is detached.
+ *
  *-------------------------------------------------------------------
  */
 
 void
-MenuToggleAction::DetachFromMenu(void)
+MenuToggleAction::OnAttachWidgetDestroyed(GtkWidget *widget, // IN
+                                          gpointer data)     // IN
 {
-   mDetachConnection.disconnect();
-   mMenu->detach();
+   MenuToggleAction *action = static_cast<MenuToggleAction *>(data);
+
+   g_signal_handler_disconnect(widget, action->mAttachDestroyId);
+   action->mAttachWidget = NULL;
+   action->mAttachDestroyId = 0;
+
+   if (gtk_menu_get_attach_widget(action->mMenu->gobj()) == widget) {
+      gtk_menu_detach(action->mMenu->gobj());
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MenuToggleAction::DetachMenu --
+ *
+ *      Detach the menu from whatever it is attached to. A menu item
+ *      losing it gets an empty stand-in again.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MenuToggleAction::DetachMenu(void)
+{
+   if (mAttachWidget) {
+      g_signal_handler_disconnect(mAttachWidget, mAttachDestroyId);
+      mAttachWidget = NULL;
+      mAttachDestroyId = 0;
+   }
+
+   Gtk::Widget *owner = mMenu->get_attach_widget();
+   if (!owner) {
+      return;
+   }
+
+   Gtk::MenuItem *item = dynamic_cast<Gtk::MenuItem *>(owner);
+   if (item && item->get_submenu() == mMenu) {
+      item->set_submenu(*Gtk::manage(new Gtk::Menu()));
+   } else {
+      mMenu->detach();
+   }
 }
 
 
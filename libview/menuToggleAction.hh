@@ -25,14 +25,22 @@
  * menuToggleAction.hh --
  *
  *      Subclass of Gtk::ToggleAction that gives a proxy with a popup/submenu.
+ *
+ *      The menu is either given up front or built by a factory slot the
+ *      first time it is needed, in which case it can be released again
+ *      and rebuilt on demand. There is only ever one menu. It stays
+ *      attached to whichever proxy last needed it: tool buttons pop it up
+ *      on right click, and menu item proxies carry an empty stand-in
+ *      submenu until they are selected and take the real one over.
  */
 
 #ifndef LIBVIEW_MENUTOGGLEACTION_HH
 #define LIBVIEW_MENUTOGGLEACTION_HH
 
 
-#include <map>
 #include <gtkmm/menu.h>
+#include <gtkmm/menuitem.h>
+#include <gtkmm/toggletoolbutton.h>
 #include <gtkmm/toggleaction.h>
 
 
@@ -42,18 +50,31 @@ class MenuToggleAction
    : public Gtk::ToggleAction
 {
 public:
+   // Returns a new menu, which the action takes ownership of.
+   typedef sigc::slot<Gtk::Menu *> MenuFactory;
+
    static Glib::RefPtr<MenuToggleAction> create(const Glib::ustring &name,
                                                 const Gtk::StockID &stockID,
                                                 const Glib::ustring &label,
                                                 const Glib::ustring &tooltip,
                                                 bool isActive,
                                                 Gtk::Menu *menu);
+   static Glib::RefPtr<MenuToggleAction> create(const Glib::ustring &name,
+                                                const Gtk::StockID &stockID,
+                                                const Glib::ustring &label,
+                                                const Glib::ustring &tooltip,
+                                                bool isActive,
+                                                const MenuFactory &menuFactory);
    ~MenuToggleAction();
 
+   Gtk::Menu *GetMenu(void);
+   bool ReleaseMenu(void);
+
 protected:
    MenuToggleAction(const Glib::ustring &name, const Gtk::StockID &stockID,
                     const Glib::ustring &label, const Glib::ustring &tooltip,
-                    bool isActive, Gtk::Menu *menu);
+                    bool isActive, Gtk::Menu *menu,
+                    const MenuFactory &menuFactory = MenuFactory());
 
    Gtk::Widget *create_menu_item_vfunc(void);
 
@@ -61,18 +82,27 @@ protected:
    void disconnect_proxy_vfunc(Gtk::Widget *widget);
 
 private:
-   bool OnButtonPressed(GdkEventButton *event, Gtk::Widget *widget);
+   static bool OnButtonPressed(GdkEventButton *event,
+                               Gtk::ToggleToolButton *toolButton);
+   void OnItemSelected(Gtk::MenuItem *item);
 
-   void DetachFromMenu(void);
+   void AttachMenu(Gtk::Widget *widget);
+   void DetachMenu(void);
+   static void OnAttachWidgetDestroyed(GtkWidget *widget, gpointer data);
    // Gtk insists on a detach callback but we don't need one.
    static void OnMenuDetached(GtkWidget *widget, GtkMenu *menu) {}
 
    // The action takes ownership of the menu.
    Gtk::Menu *mMenu;
-
-   sigc::connection mDetachConnection;
-
-   std::map<Gtk::Widget *, sigc::connection> widgetMap;
+   MenuFactory mMenuFactory;
+
+   /*
+    * GtkMenu doesn't notice its attach widget going away, and a menu item
+    * destroys its submenu along with itself, so the proxy the menu is
+    * attached to is watched for "destroy".
+    */
+   GtkWidget *mAttachWidget;
+   gulong mAttachDestroyId;
 };
 
 } // namespace view
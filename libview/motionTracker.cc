@@ -31,6 +31,8 @@
  */
 
 
+#include <gdk/gdkx.h>
+
 #include <libview/motionTracker.hh>
 #include <X11/Xlib.h>
 
@@ -38,6 +40,9 @@
 namespace view {
 
 
+GHashTable *MotionTracker::sWindows = NULL;
+
+
 /*
  *-------------------------------------------------------------------
  *
@@ -55,15 +60,16 @@ namespace view {
  */
 
 MotionTracker::MotionTracker(Gtk::Widget &target) // IN
-   : mTarget(target)
+   : mTarget(NULL),
+     mOriginValid(false),
+     mOriginX(0),
+     mOriginY(0),
+     mOriginSerial(0),
+     mOffsetValid(true),
+     mOffsetX(0),
+     mOffsetY(0)
 {
-   mTarget.signal_unrealize().connect_notify(
-      sigc::mem_fun(this, &MotionTracker::DisconnectWindows));
-   mTarget.signal_realize().connect_notify(
-      sigc::mem_fun(this, &MotionTracker::ReconnectWindows));
-   ConnectWindows();
-
-   mTarget.signal_size_allocate().connect_notify(sigc::hide(make_slot()));
+   SetTarget(&target);
 }
 
 
@@ -85,7 +91,55 @@ MotionTracker::MotionTracker(Gtk::Widget &target) // IN
 
 MotionTracker::~MotionTracker()
 {
+   mIdleEmit.disconnect();
+   SetTarget(NULL);
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MotionTracker::SetTarget --
+ *
+ *      Start tracking a different widget, or none at all if target is
+ *      NULL. This lets a long-lived owner, such as a pooled ToolTip,
+ *      reuse one tracker for many widgets.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MotionTracker::SetTarget(Gtk::Widget *target) // IN
+{
+   if (target == mTarget) {
+      return;
+   }
+
+   mUnrealizeConnection.disconnect();
+   mRealizeConnection.disconnect();
+   mSizeAllocateConnection.disconnect();
    DisconnectWindows();
+
+   mTarget = target;
+   if (!mTarget) {
+      mIdleEmit.disconnect();
+      return;
+   }
+
+   mUnrealizeConnection = mTarget->signal_unrealize().connect_notify(
+      sigc::mem_fun(this, &MotionTracker::DisconnectWindows));
+   mRealizeConnection = mTarget->signal_realize().connect_notify(
+      sigc::mem_fun(this, &MotionTracker::ReconnectWindows));
+   ConnectWindows();
+
+   mSizeAllocateConnection = mTarget->signal_size_allocate().connect_notify(
+      sigc::hide(sigc::mem_fun(this, &MotionTracker::QueueEmit)));
 }
 
 
@@ -94,8 +148,7 @@ MotionTracker::~MotionTracker()
  *
  * view::MotionTracker::ConnectWindows --
  *
- *      Add event filters to all parent GdkWindows of the target
- *      widget.
+ *      Start watching the target's GdkWindow and all of its parents.
  *
  * Results:
  *      None
@@ -109,17 +162,40 @@ MotionTracker::~MotionTracker()
 void
 MotionTracker::ConnectWindows(void)
 {
-   Glib::RefPtr<Gdk::Window> window = mTarget.get_window();
-   while (window) {
-      window->add_filter(MotionTracker::OnXEvent, this);
+   if (!mTarget) {
+      return;
+   }
 
+   Glib::RefPtr<Gdk::Window> window = mTarget->get_window();
+   while (window) {
       /*
        * We don't need to know directly that a parent window has disappeared.
-       * We only need to know to skip the non-existent window when disconnecting.
+       * We only need to know to ignore the non-existent window if its XID
+       * is reused before we disconnect.
+       *
+       * The X position of each window is learnt from its first
+       * ConfigureNotify; GDK's idea of a child's position can differ from
+       * the X one, so we can't seed it from there.
        */
-      mWindows.push_back(WeakPtr<Gdk::Window>(window.operator->()));
+      Glib::RefPtr<Gdk::Window> parent = window->get_parent();
+      TrackedWindow tracked;
+      tracked.tracker = this;
+      tracked.prev = NULL;
+      tracked.next = NULL;
+      tracked.window = window.operator->();
+      tracked.xid = GDK_WINDOW_XID(window->gobj());
+      tracked.toplevel = parent && !parent->get_parent();
+      tracked.known = false;
+      tracked.x = 0;
+      tracked.y = 0;
+      mWindows.push_back(tracked);
 
-      window = window->get_parent();
+      window = parent;
+   }
+
+   // Only link once the vector is complete and the nodes won't move.
+   for (WindowVector::size_type i = 0; i < mWindows.size(); i++) {
+      LinkWindow(mWindows[i]);
    }
 }
 
@@ -129,8 +205,7 @@ MotionTracker::ConnectWindows(void)
  *
  * view::MotionTracker::DisconnectWindows --
  *
- *      Remove event filters from parent GdkWindows - if they're still
- *      around.
+ *      Stop watching the windows we connected to.
  *
  * Results:
  *      None
@@ -145,11 +220,10 @@ void
 MotionTracker::DisconnectWindows(void)
 {
    for (WindowVector::size_type i = 0; i < mWindows.size(); i++) {
-      if (mWindows[i]) {
-         mWindows[i]->remove_filter(MotionTracker::OnXEvent, this);
-      }
+      UnlinkWindow(mWindows[i]);
    }
    mWindows.clear();
+   InvalidateOrigin();
 }
 
 
@@ -164,7 +238,7 @@ MotionTracker::DisconnectWindows(void)
  *      None
  *
  * Side effects:
- *      Anything - the signal emits itself.
+ *      The signal will emit itself from an idle handler.
  *
  *-------------------------------------------------------------------
  */
@@ -176,7 +250,310 @@ MotionTracker::ReconnectWindows(void)
    ConnectWindows();
 
    // We should explicitly notify after this change.
+   QueueEmit();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MotionTracker::GetOrigin --
+ *
+ *      Get the root origin of the target's window, as
+ *      Gdk::Window::get_origin would. The origin is cached and kept up
+ *      to date from ConfigureNotify events, so this normally does not
+ *      talk to the X server. It only does so after an event we could
+ *      not account for, such as a reparent.
+ *
+ * Results:
+ *      The origin, or 0,0 if the target is not realized.
+ *
+ * Side effects:
+ *      May refresh the cached origin.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MotionTracker::GetOrigin(int &x, // OUT
+                         int &y) // OUT
+{
+   if (!mOriginValid) {
+      Glib::RefPtr<Gdk::Window> window;
+      if (mTarget) {
+         window = mTarget->get_window();
+      }
+      if (!window) {
+         x = y = 0;
+         return;
+      }
+
+      /*
+       * Events generated before the server handles our query are already
+       * accounted for in its reply. Remember where that boundary is so
+       * OnConfigure does not apply them twice.
+       */
+      mOriginSerial = NextRequest(GDK_WINDOW_XDISPLAY(window->gobj()));
+      window->get_origin(mOriginX, mOriginY);
+      mOriginValid = true;
+   }
+
+   x = mOriginX;
+   y = mOriginY;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MotionTracker::GetOffset --
+ *
+ *      Get how far the target's window has moved since the previous
+ *      emission. Only meaningful while the signal is being emitted.
+ *
+ * Results:
+ *      true and the offset if it is known, false if the window moved in
+ *      a way we could not follow and listeners should use GetOrigin.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+MotionTracker::GetOffset(int &dx, // OUT
+                         int &dy) // OUT
+   const
+{
+   dx = mOffsetX;
+   dy = mOffsetY;
+   return mOffsetValid;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MotionTracker::QueueEmit --
+ *
+ *      Arrange for the signal to be emitted once the pending events
+ *      have been handled. Any number of calls before then result in a
+ *      single emission.
+ *
+ *      The idle runs ahead of GTK+'s resize and redraw handlers, so
+ *      listeners can still move things before the next repaint.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MotionTracker::QueueEmit(void)
+{
+   if (!mIdleEmit.connected()) {
+      mIdleEmit = Glib::signal_idle().connect(
+         sigc::mem_fun(this, &MotionTracker::OnIdleEmit),
+         Glib::PRIORITY_HIGH_IDLE);
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MotionTracker::OnIdleEmit --
+ *
+ *      Idle callback that emits the coalesced notification and resets
+ *      the accumulated offset.
+ *
+ * Results:
+ *      false to remove the idle.
+ *
+ * Side effects:
+ *      Anything - the signal emits itself.
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+MotionTracker::OnIdleEmit(void)
+{
    emit();
+
+   mOffsetValid = true;
+   mOffsetX = 0;
+   mOffsetY = 0;
+   return false;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MotionTracker::InvalidateOrigin --
+ *
+ *      Forget the cached origin, because the window moved in a way
+ *      that can't be worked out from the events alone.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The next GetOrigin will query the X server.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MotionTracker::InvalidateOrigin(void)
+{
+   mOriginValid = false;
+   mOffsetValid = false;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MotionTracker::OnConfigure --
+ *
+ *      Account for a ConfigureNotify on one of our windows by moving
+ *      the cached origin by the change in the window's position.
+ *
+ *      Child windows get real events in parent co-ordinates. A toplevel
+ *      is usually reparented by the window manager, so its real events
+ *      are relative to the frame; the synthetic events the window
+ *      manager sends (ICCCM 4.1.5) are in root co-ordinates and are the
+ *      only ones we can follow.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The cached origin and offset are updated or invalidated.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MotionTracker::OnConfigure(TrackedWindow &tracked, // IN/OUT
+                           int x,                  // IN
+                           int y,                  // IN
+                           bool synthetic,         // IN
+                           unsigned long serial)   // IN
+{
+   if (!tracked.window
+       || tracked.window->get_window_type() == Gdk::WINDOW_ROOT) {
+      return;
+   }
+
+   if (synthetic != tracked.toplevel) {
+      /*
+       * A real event on a toplevel is relative to an unknown frame, and
+       * nothing but the window manager should send a synthetic one.
+       */
+      if (!synthetic) {
+         InvalidateOrigin();
+      }
+      return;
+   }
+
+   bool included = mOriginValid && serial < mOriginSerial;
+   if (!included) {
+      if (!tracked.known) {
+         InvalidateOrigin();
+      } else if (x != tracked.x || y != tracked.y) {
+         mOriginX += x - tracked.x;
+         mOriginY += y - tracked.y;
+         mOffsetX += x - tracked.x;
+         mOffsetY += y - tracked.y;
+      }
+   }
+
+   tracked.known = true;
+   tracked.x = x;
+   tracked.y = y;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MotionTracker::LinkWindow --
+ *
+ *      Add a tracked window to the list of trackers interested in its
+ *      XID. The first call installs our single GDK event filter.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MotionTracker::LinkWindow(TrackedWindow &tracked) // IN/OUT
+{
+   if (!sWindows) {
+      sWindows = g_hash_table_new(g_direct_hash, g_direct_equal);
+      gdk_window_add_filter(NULL, MotionTracker::OnXEvent, NULL);
+   }
+
+   gpointer key = GSIZE_TO_POINTER(tracked.xid);
+   TrackedWindow *head =
+      static_cast<TrackedWindow *>(g_hash_table_lookup(sWindows, key));
+
+   tracked.prev = NULL;
+   tracked.next = head;
+   if (head) {
+      head->prev = &tracked;
+   }
+   g_hash_table_insert(sWindows, key, &tracked);
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::MotionTracker::UnlinkWindow --
+ *
+ *      Remove a tracked window from the list for its XID.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+MotionTracker::UnlinkWindow(TrackedWindow &tracked) // IN/OUT
+{
+   if (tracked.next) {
+      tracked.next->prev = tracked.prev;
+   }
+
+   if (tracked.prev) {
+      tracked.prev->next = tracked.next;
+   } else if (tracked.next) {
+      g_hash_table_insert(sWindows, GSIZE_TO_POINTER(tracked.xid),
+                          tracked.next);
+   } else {
+      g_hash_table_remove(sWindows, GSIZE_TO_POINTER(tracked.xid));
+   }
+
+   tracked.prev = NULL;
+   tracked.next = NULL;
 }
 
 
@@ -185,15 +562,16 @@ MotionTracker::ReconnectWindows(void)
  *
  * view::MotionTracker::OnXEvent --
  *
- *      Filter callback to be attached to parent X windows. We use this
- *      to respond to X events that GDK hides from us.
+ *      Global GDK filter shared by all trackers. We use this to respond
+ *      to X events that GDK hides from us, and hand them to the
+ *      trackers watching the event's window.
  *
  * Results:
  *      GDK_FILTER_CONTINUE - to allow for full handling of the event.
  *
  * Side effects:
- *      Anything - the signal emits itself if a ConfigureNotify
- *      event is received.
+ *      Trackers queue an emission if a ConfigureNotify event is
+ *      received for one of their windows.
  *
  *-------------------------------------------------------------------
  */
@@ -201,27 +579,56 @@ MotionTracker::ReconnectWindows(void)
 GdkFilterReturn
 MotionTracker::OnXEvent(GdkXEvent *gdkXEvent, // IN
                         GdkEvent *event,      // IN
-                        gpointer data)        // IN
+                        gpointer data)        // IN: Unused
 {
-   MotionTracker *tracker = reinterpret_cast<MotionTracker *>(data);
-
    /*
     * Both ConfigureNotify and ReparentNotify will be received if
     * StructureNotifyMask is in the X window event mask. GDK explicitly
     * sets this, so we know we will see both types of event here.
     */
    XEvent *xEvent = reinterpret_cast<XEvent *>(gdkXEvent);
+   if (xEvent->type != ConfigureNotify && xEvent->type != ReparentNotify) {
+      return GDK_FILTER_CONTINUE;
+   }
+
+   TrackedWindow *tracked = static_cast<TrackedWindow *>(
+      g_hash_table_lookup(sWindows, GSIZE_TO_POINTER(xEvent->xany.window)));
+
    if (xEvent->type == ConfigureNotify) {
       /*
        * GDK discards ConfigureNotify for all but toplevel windows.
+       *
+       * Only look at the window's own StructureNotify events; if a
+       * parent also selects SubstructureNotify we would otherwise count
+       * the same move twice.
        */
-      tracker->emit();
-   } else if (xEvent->type == ReparentNotify) {
+      const XConfigureEvent &configure = xEvent->xconfigure;
+      bool own = configure.event == configure.window;
+
+      for (; tracked; tracked = tracked->next) {
+         if (own) {
+            tracked->tracker->OnConfigure(*tracked, configure.x, configure.y,
+                                          configure.send_event,
+                                          configure.serial);
+         }
+         tracked->tracker->QueueEmit();
+      }
+   } else {
       /*
        * GDK does not translate ReparentNotify. This is the only place
        * to detect it.
+       *
+       * Reconnecting relinks the tracker's windows, so collect the
+       * trackers before touching any of them.
        */
-      tracker->ReconnectWindows();
+      std::vector<MotionTracker *> trackers;
+      for (; tracked; tracked = tracked->next) {
+         trackers.push_back(tracked->tracker);
+      }
+      for (std::vector<MotionTracker *>::size_type i = 0;
+           i < trackers.size(); i++) {
+         trackers[i]->ReconnectWindows();
+      }
    }
 
    return GDK_FILTER_CONTINUE;
@@ -35,6 +35,12 @@
  *
  *      If the target happens to disappear while the tracker is still alive,
  *      it will completely disconnect itself from all windows and become inert.
+ *
+ *      Bursts of motion (such as a window being dragged) are coalesced
+ *      into a single emission per main loop iteration. The tracker keeps
+ *      the root origin of the target's window up to date from the
+ *      ConfigureNotify data, so listeners can call GetOrigin rather than
+ *      Gdk::Window::get_origin and avoid an X round trip.
  */
 
 #ifndef LIBVIEW_MOTIONTRACKER_HH
@@ -42,6 +48,7 @@
 
 
 #include <gtkmm/widget.h>
+#include <glibmm/main.h>
 
 #include <libview/weakPtr.hh>
 
@@ -55,18 +62,61 @@ public:
    MotionTracker(Gtk::Widget &target);
    ~MotionTracker();
 
+   void SetTarget(Gtk::Widget *target);
+
+   void GetOrigin(int &x, int &y);
+   bool GetOffset(int &dx, int &dy) const;
+
 private:
-   typedef std::vector<WeakPtr<Gdk::Window> > WindowVector;
+   /*
+    * Every tracked window is linked into a process-wide list of the
+    * trackers watching that X window, looked up by XID from a single
+    * GDK filter.
+    */
+   struct TrackedWindow {
+      MotionTracker *tracker;
+      TrackedWindow *prev;
+      TrackedWindow *next;
+      WeakPtr<Gdk::Window> window;
+      unsigned long xid;
+      bool toplevel;
+      bool known;
+      int x;
+      int y;
+   };
+
+   typedef std::vector<TrackedWindow> WindowVector;
 
    void ConnectWindows(void);
    void DisconnectWindows(void);
    void ReconnectWindows(void);
-
+   void QueueEmit(void);
+   bool OnIdleEmit(void);
+   void OnConfigure(TrackedWindow &tracked, int x, int y, bool synthetic,
+                    unsigned long serial);
+   void InvalidateOrigin(void);
+
+   static void LinkWindow(TrackedWindow &tracked);
+   static void UnlinkWindow(TrackedWindow &tracked);
    static GdkFilterReturn OnXEvent(GdkXEvent *gdkXEvent, GdkEvent *event,
                                    gpointer data);
 
-   Gtk::Widget &mTarget;
+   static GHashTable *sWindows;
+
+   Gtk::Widget *mTarget;
+   sigc::connection mUnrealizeConnection;
+   sigc::connection mRealizeConnection;
+   sigc::connection mSizeAllocateConnection;
    WindowVector mWindows;
+   sigc::connection mIdleEmit;
+
+   bool mOriginValid;
+   int mOriginX;
+   int mOriginY;
+   unsigned long mOriginSerial;
+   bool mOffsetValid;
+   int mOffsetX;
+   int mOffsetY;
 };
 
 
@@ -93,6 +93,10 @@ struct _ViewOvBoxPrivate
 /* The unaltered parent class. */
 static GtkBoxClass *parentClass;
 
+/* Boxes waiting for ViewOvBoxBackgroundIdle to set their background. */
+static GSList *pendingBackgrounds = NULL;
+static guint backgroundIdle = 0;
+
 
 /*
  *-----------------------------------------------------------------------------
@@ -387,6 +391,79 @@ ViewOvBoxSetBackground(ViewOvBox *that) // IN
 }
 
 
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * ViewOvBoxBackgroundIdle --
+ *
+ *      Idle handler that sets the background of every box whose style
+ *      changed since the last run.
+ *
+ * Results:
+ *      FALSE to remove the idle handler.
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static gboolean
+ViewOvBoxBackgroundIdle(gpointer data) // Unused
+{
+   GSList *pending;
+   GSList *l;
+
+   pending = pendingBackgrounds;
+   pendingBackgrounds = NULL;
+   backgroundIdle = 0;
+
+   for (l = pending; l; l = l->next) {
+      ViewOvBoxSetBackground(VIEW_OV_BOX(l->data));
+   }
+   g_slist_free(pending);
+
+   return FALSE;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * ViewOvBoxQueueBackground --
+ *
+ *      Have the background of a realized ViewOvBox set from an idle
+ *      handler. A theme change sets the style of every widget, possibly
+ *      several times, and this sets each box's three backgrounds once
+ *      for all of that.
+ *
+ *      The idle handler runs before GTK+ resizes and redraws for the new
+ *      style, so nothing is drawn with the old background.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+ViewOvBoxQueueBackground(ViewOvBox *that) // IN
+{
+   if (g_slist_find(pendingBackgrounds, that)) {
+      return;
+   }
+
+   pendingBackgrounds = g_slist_prepend(pendingBackgrounds, that);
+   if (!backgroundIdle) {
+      backgroundIdle = g_idle_add_full(G_PRIORITY_HIGH_IDLE,
+                                       ViewOvBoxBackgroundIdle, NULL, NULL);
+   }
+}
+
+
 /*
  *-----------------------------------------------------------------------------
  *
@@ -493,6 +570,7 @@ ViewOvBoxUnrealize(GtkWidget *widget) // IN
     */
    GTK_WIDGET_CLASS(parentClass)->unrealize(widget);
 
+   pendingBackgrounds = g_slist_remove(pendingBackgrounds, that);
 
    gdk_window_set_user_data(priv->underWin, NULL);
    gdk_window_destroy(priv->underWin);
@@ -618,7 +696,7 @@ ViewOvBoxSizeAllocate(GtkWidget *widget,         // IN
  *      None
  *
  * Side effects:
- *      None
+ *      The background is set later, unless it doesn't change.
  *
  *-----------------------------------------------------------------------------
  */
@@ -631,8 +709,13 @@ ViewOvBoxStyleSet(GtkWidget *widget,       // IN
 
    that = VIEW_OV_BOX(widget);
 
-   if (GTK_WIDGET_REALIZED(widget)) {
-      ViewOvBoxSetBackground(that);
+   if (GTK_WIDGET_REALIZED(widget) &&
+       (!previousStyle ||
+        !gdk_color_equal(&previousStyle->bg[GTK_STATE_NORMAL],
+                         &widget->style->bg[GTK_STATE_NORMAL]) ||
+        previousStyle->bg_pixmap[GTK_STATE_NORMAL] !=
+           widget->style->bg_pixmap[GTK_STATE_NORMAL])) {
+      ViewOvBoxQueueBackground(that);
    }
 
    GTK_WIDGET_CLASS(parentClass)->style_set(widget, previousStyle);
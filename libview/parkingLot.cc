@@ -0,0 +1,129 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * parkingLot.cc --
+ *
+ *      Implements the ParkingLot class.
+ */
+
+
+#include <libview/parkingLot.hh>
+
+
+#define PARKING_LOT_KEY "libview-parking-lot"
+
+
+namespace view {
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ParkingLot::Get --
+ *
+ *      Get the parking lot of a screen, creating it on first use. It
+ *      lives as long as the screen does.
+ *
+ * Results:
+ *      The parking lot.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+ParkingLot &
+ParkingLot::Get(const Glib::RefPtr<Gdk::Screen> &screen) // IN
+{
+   GObject *object = G_OBJECT(screen->gobj());
+   ParkingLot *lot =
+      static_cast<ParkingLot *>(g_object_get_data(object, PARKING_LOT_KEY));
+
+   if (!lot) {
+      lot = new ParkingLot(screen);
+      g_object_set_data_full(object, PARKING_LOT_KEY, lot,
+                             &ParkingLot::OnDestroy);
+   }
+
+   return *lot;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ParkingLot::ParkingLot --
+ *
+ *      Constructor. The window is realized straight away but never
+ *      shown. Parked widgets are placed in a Gtk::Fixed so they don't
+ *      affect each other's allocation.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+ParkingLot::ParkingLot(const Glib::RefPtr<Gdk::Screen> &screen) // IN
+   : Gtk::Window(Gtk::WINDOW_POPUP)
+{
+   set_screen(screen);
+   set_title("libview parking lot");
+
+   mFixed.show();
+   add(mFixed);
+
+   realize();
+   mFixed.realize();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ParkingLot::OnDestroy --
+ *
+ *      Destroy notify for the parking lot attached to a screen.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ParkingLot::OnDestroy(gpointer data) // IN
+{
+   delete static_cast<ParkingLot *>(data);
+}
+
+
+} // namespace view
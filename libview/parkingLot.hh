@@ -0,0 +1,64 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * parkingLot.hh --
+ *
+ *      A hidden but realized toplevel, one per screen, that widgets can be
+ *      parked in while they move between toplevels. As long as a widget
+ *      only ever moves between realized parents, gtk_widget_reparent()
+ *      keeps it realized, so it keeps its X windows, GCs and pixmaps.
+ */
+
+#ifndef LIBVIEW_PARKING_LOT_HH
+#define LIBVIEW_PARKING_LOT_HH
+
+
+#include <gtkmm/fixed.h>
+#include <gtkmm/window.h>
+
+
+namespace view {
+
+
+class ParkingLot
+   : public Gtk::Window
+{
+public:
+   static ParkingLot &Get(const Glib::RefPtr<Gdk::Screen> &screen);
+
+   Gtk::Container &GetContainer(void) { return mFixed; }
+
+private:
+   ParkingLot(const Glib::RefPtr<Gdk::Screen> &screen);
+
+   static void OnDestroy(gpointer data);
+
+   Gtk::Fixed mFixed;
+};
+
+
+} // namespace view
+
+
+#endif // LIBVIEW_PARKING_LOT_HH
@@ -79,19 +79,38 @@
  *    So the trick is to lie to GTK: we let it think that the window is
  *    visible, but in secret we ask GDK to hide it.
  *
- * 3) Forcefully mark all the widget's GTK children as needing a size
- *    re-allocation.
+ * 3) Mark the widget as needing a size re-allocation, so that we are sure
+ *    to see the "size_allocate" workaround 2 waits for. Its descendants
+ *    keep their cached requisitions unless they can depend on the new
+ *    parent: if the screen or colormap changed, all of them are marked;
+ *    otherwise only those whose style changed are.
  *
  *  --hpreg
+ *
+ * Parking
+ * -------
+ * gtk_widget_reparent() only keeps the widget realized if the new parent is
+ * realized too. When the destination toplevel doesn't exist or isn't
+ * realized yet (e.g. while switching to fullscreen), Park() moves the widget
+ * to the screen's ParkingLot, a realized toplevel that is never shown, so it
+ * keeps its X resources until it can be moved to its real parent. Reparent()
+ * does this by itself when given an unrealized parent, and finishes the move
+ * once that parent is realized.
  */
 
 
+#include <algorithm>
+
+#include <libview/parkingLot.hh>
 #include <libview/reparenter.hh>
 
 
 namespace view {
 
 
+unsigned long Reparenter::sSkippedResizes = 0;
+
+
 /*
  *-----------------------------------------------------------------------------
  *
@@ -110,7 +129,9 @@ namespace view {
 
 Reparenter::Reparenter(Gtk::Widget &widget) // IN
    : mWidget(widget),
-     mTrackable(NULL)
+     mTrackable(NULL),
+     mSlotCalled(false),
+     mWasMapped(false)
 {
 }
 
@@ -133,6 +154,7 @@ Reparenter::Reparenter(Gtk::Widget &widget) // IN
 
 Reparenter::~Reparenter()
 {
+   mRealizeCnx.disconnect();
    delete mTrackable;
 }
 
@@ -223,6 +245,7 @@ Reparenter::OnSlotCalled(sigc::trackable &trackable) // IN
    g_assert(&trackable == mTrackable);
    delete mTrackable;
    mTrackable = NULL;
+   mSlotCalled = true;
 
    OnEvent();
 }
@@ -259,13 +282,12 @@ Reparenter::RecurseQueueResize(Gtk::Widget &widget) // IN
 /*
  *-----------------------------------------------------------------------------
  *
- * view::Reparenter::Reparent --
+ * view::Reparenter::CollectStyles --
  *
- *      Reparent a Reparenter's widget in 'newParent'.
+ *      Recursively record the style of every descendant of 'widget'.
  *
  * Results:
- *      A slot that client code must invoke when it is ready for the GDK window
- *      to be shown again.
+ *      None
  *
  * Side effects:
  *      None
@@ -273,8 +295,128 @@ Reparenter::RecurseQueueResize(Gtk::Widget &widget) // IN
  *-----------------------------------------------------------------------------
  */
 
-sigc::slot<void>
-Reparenter::Reparent(Gtk::Container &newParent) // IN
+void
+Reparenter::CollectStyles(Gtk::Widget &widget, // IN
+                          StyleVector *styles) // IN/OUT
+{
+   Gtk::Container *container = dynamic_cast<Gtk::Container *>(&widget);
+   if (!container) {
+      return;
+   }
+
+   std::vector<Gtk::Widget *> children = container->get_children();
+   for (std::vector<Gtk::Widget *>::size_type i = 0; i < children.size();
+        i++) {
+      Gtk::Widget *child = children[i];
+
+      styles->push_back(std::make_pair(child, child->gobj()->style));
+      CollectStyles(*child, styles);
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::Reparenter::QueueStyleResizes --
+ *
+ *      Call queue_resize() on the widgets whose style is not the one
+ *      recorded by CollectStyles(), and count the ones we skip.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+Reparenter::QueueStyleResizes(const StyleVector &styles) // IN
+{
+   for (StyleVector::size_type i = 0; i < styles.size(); i++) {
+      if (styles[i].first->gobj()->style != styles[i].second) {
+         styles[i].first->queue_resize();
+      } else {
+         sSkippedResizes++;
+      }
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::Reparenter::GetSkippedResizeCount --
+ *
+ *      Get how many descendants of reparented widgets kept their cached
+ *      requisition, compared to forcing a resize of the whole subtree.
+ *
+ * Results:
+ *      The number of queue_resize() calls avoided so far.
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+unsigned long
+Reparenter::GetSkippedResizeCount(void)
+{
+   return sSkippedResizes;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::Reparenter::CancelPending --
+ *
+ *      Forget about the previous reparent: stop waiting for its allocation,
+ *      its slot and its parent's realization.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The slot returned for the previous reparent becomes a no-op.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+Reparenter::CancelPending(void)
+{
+   mCnx.disconnect();
+   mRealizeCnx.disconnect();
+   delete mTrackable;
+   mTrackable = NULL;
+   mSlotCalled = false;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::Reparenter::HideWindow --
+ *
+ *      First half of a reparent: secretly hide the widget's GDK window
+ *      (workaround 2). The caller must sync the display before the window
+ *      is actually reparented.
+ *
+ * Results:
+ *      true if a window was hidden and a sync is needed.
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+bool
+Reparenter::HideWindow(void)
 {
    /*
     * Workaround 1: We check that property every time this method is
@@ -283,25 +425,63 @@ Reparenter::Reparent(Gtk::Container &newParent) // IN
     */
    g_assert(!mWidget.has_no_window());
 
-   mCnx.disconnect();
-   delete mTrackable;
-   mTrackable = NULL;
-
-   if (mWidget.is_mapped()) {
-      g_assert(mWidget.is_realized());
+   CancelPending();
 
-      /*
-       * Workaround 2: It is OK not to tell GTK (i.e. not to change the
-       * result of is_mapped()), because unmapping a GDK window is an
-       * idempotent operation.
-       */
-      mWidget.get_window()->hide();
-      mWidget.get_display()->sync();
+   if (!mWidget.is_mapped()) {
+      return false;
    }
 
+   g_assert(mWidget.is_realized());
+
+   /*
+    * Workaround 2: It is OK not to tell GTK (i.e. not to change the
+    * result of is_mapped()), because unmapping a GDK window is an
+    * idempotent operation.
+    */
+   mWidget.get_window()->hide();
+   return true;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::Reparenter::FinishReparent --
+ *
+ *      Second half of a reparent, once the hidden window has been synced:
+ *      move the widget to 'newParent'. If the slot of a deferred reparent
+ *      is still pending, it is the one that completes this reparent.
+ *
+ * Results:
+ *      A slot that client code must invoke when it is ready for the GDK window
+ *      to be shown again.
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+sigc::slot<void>
+Reparenter::FinishReparent(Gtk::Container &newParent) // IN
+{
    mCnx = mWidget.signal_size_allocate().connect(
       sigc::hide(sigc::mem_fun(this, &Reparenter::OnWidgetSizeAllocate)));
-   mTrackable = new sigc::trackable();
+
+   /*
+    * A deferred reparent already handed out its slot, which may have been
+    * invoked while waiting for the parent: then there is nothing left to
+    * wait for.
+    */
+   if (!mTrackable && !mSlotCalled) {
+      mTrackable = new sigc::trackable();
+   }
+   mSlotCalled = false;
+
+   Glib::RefPtr<Gdk::Screen> oldScreen = mWidget.get_screen();
+   Glib::RefPtr<Gdk::Colormap> oldColormap = mWidget.get_colormap();
+   StyleVector styles;
+   CollectStyles(mWidget, &styles);
 
    mWidget.reparent(newParent);
 
@@ -312,16 +492,216 @@ Reparenter::Reparent(Gtk::Container &newParent) // IN
    mWasMapped = mWidget.is_mapped();
 
    /* Workaround 3 */
-   RecurseQueueResize(mWidget);
+   if (mWidget.get_screen() != oldScreen
+       || mWidget.get_colormap() != oldColormap) {
+      RecurseQueueResize(mWidget);
+   } else {
+      mWidget.queue_resize();
+      QueueStyleResizes(styles);
+   }
 
    /*
     * We purposedly bind a reference to the sigc::trackable object to the slot,
     * so we can invalidate the slot (i.e. make sure we won't be called back) at
     * any time by destroying the object.
     */
+   if (!mTrackable) {
+      return sigc::slot<void>();
+   }
    return sigc::bind(sigc::mem_fun(this, &Reparenter::OnSlotCalled),
                      sigc::ref(*mTrackable));
 }
 
 
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::Reparenter::Reparent --
+ *
+ *      Reparent a Reparenter's widget in 'newParent'.
+ *
+ *      gtk_widget_reparent() unrealizes the widget if 'newParent' isn't
+ *      realized, so in that case the widget is parked instead, and moved
+ *      to 'newParent' when it is realized.
+ *
+ * Results:
+ *      A slot that client code must invoke when it is ready for the GDK window
+ *      to be shown again.
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+sigc::slot<void>
+Reparenter::Reparent(Gtk::Container &newParent) // IN
+{
+   if (!newParent.is_realized()) {
+      Park();
+
+      mRealizeCnx = newParent.signal_realize().connect(
+         sigc::bind(sigc::mem_fun(this, &Reparenter::OnParentRealized),
+                    sigc::ref(newParent)));
+      mTrackable = new sigc::trackable();
+      return sigc::bind(sigc::mem_fun(this, &Reparenter::OnSlotCalled),
+                        sigc::ref(*mTrackable));
+   }
+
+   if (HideWindow()) {
+      mWidget.get_display()->sync();
+   }
+
+   return FinishReparent(newParent);
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::Reparenter::OnParentRealized --
+ *
+ *      "realize" signal handler for the parent a deferred Reparent() is
+ *      waiting for. The widget is parked and so not mapped, so there is no
+ *      window to hide before moving it.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+Reparenter::OnParentRealized(Gtk::Container &newParent) // IN
+{
+   mRealizeCnx.disconnect();
+   FinishReparent(newParent);
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::Reparenter::Park --
+ *
+ *      Reparent a Reparenter's widget in the parking lot of its screen, so
+ *      it stays realized until it is reparented in its next parent. Any
+ *      reparent still in progress is abandoned.
+ *
+ *      The parking lot is never shown, so the widget is simply unmapped:
+ *      there is no window to hide first and nothing for client code to
+ *      wait for.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The parking lot is created if needed.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+Reparenter::Park(void)
+{
+   CancelPending();
+
+   mWidget.reparent(ParkingLot::Get(mWidget.get_screen()).GetContainer());
+   mWasMapped = false;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::Reparenter::ReparentBatch --
+ *
+ *      Reparent several widgets at once, e.g. when switching between
+ *      windowed and fullscreen layouts. All the GDK windows are hidden
+ *      first, then a single X sync is made per display instead of one per
+ *      widget, then every widget is moved. Moves to unrealized parents
+ *      are deferred as in Reparent().
+ *
+ * Results:
+ *      A slot that client code must invoke when it is ready for the GDK
+ *      windows to be shown again. It completes every move of the batch.
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+sigc::slot<void>
+Reparenter::ReparentBatch(const MoveVector &moves) // IN
+{
+   std::vector<Glib::RefPtr<Gdk::Display> > displays;
+
+   /*
+    * Moving a widget can realize the parent of a later move, so decide
+    * up front which moves were prepared here and which are deferred.
+    */
+   std::vector<bool> realized;
+   for (MoveVector::size_type i = 0; i < moves.size(); i++) {
+      Reparenter *reparenter = moves[i].first;
+
+      realized.push_back(moves[i].second->is_realized());
+      if (realized.back() && reparenter->HideWindow()) {
+         Glib::RefPtr<Gdk::Display> display =
+            reparenter->mWidget.get_display();
+
+         if (std::find(displays.begin(), displays.end(), display)
+             == displays.end()) {
+            displays.push_back(display);
+         }
+      }
+   }
+
+   for (std::vector<Glib::RefPtr<Gdk::Display> >::size_type i = 0;
+        i < displays.size(); i++) {
+      displays[i]->sync();
+   }
+
+   SlotVector slots;
+   for (MoveVector::size_type i = 0; i < moves.size(); i++) {
+      Reparenter *reparenter = moves[i].first;
+      Gtk::Container &newParent = *moves[i].second;
+
+      slots.push_back(realized[i]
+                      ? reparenter->FinishReparent(newParent)
+                      : reparenter->Reparent(newParent));
+   }
+
+   return sigc::bind(sigc::ptr_fun(&Reparenter::CallSlots), slots);
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::Reparenter::CallSlots --
+ *
+ *      Invoke each slot of a batch returned by ReparentBatch().
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+Reparenter::CallSlots(SlotVector slots) // IN
+{
+   for (SlotVector::size_type i = 0; i < slots.size(); i++) {
+      slots[i]();
+   }
+}
+
+
 } /* namespace view */
@@ -31,6 +31,7 @@
 #   define LIBVIEW_REPARENTER_HH
 
 
+#include <vector>
 #include <gtkmm/container.h>
 
 
@@ -43,19 +44,41 @@ public:
    Reparenter(Gtk::Widget &widget);
    ~Reparenter();
 
+   typedef std::pair<Reparenter *, Gtk::Container *> Move;
+   typedef std::vector<Move> MoveVector;
+
    sigc::slot<void> Reparent(Gtk::Container &newParent);
+   void Park(void);
+   static sigc::slot<void> ReparentBatch(const MoveVector &moves);
+
+   static unsigned long GetSkippedResizeCount(void);
 
 private:
+   typedef std::vector<sigc::slot<void> > SlotVector;
+   typedef std::vector<std::pair<Gtk::Widget *, GtkStyle *> > StyleVector;
+
    static void RecurseQueueResize(Gtk::Widget &widget);
+   static void CollectStyles(Gtk::Widget &widget, StyleVector *styles);
+   static void QueueStyleResizes(const StyleVector &styles);
+   static void CallSlots(SlotVector slots);
+
+   void CancelPending(void);
+   bool HideWindow(void);
+   sigc::slot<void> FinishReparent(Gtk::Container &newParent);
 
    void OnEvent(void);
    void OnWidgetSizeAllocate(void);
+   void OnParentRealized(Gtk::Container &newParent);
    void OnSlotCalled(sigc::trackable &trackable);
 
    Gtk::Widget &mWidget;
    sigc::connection mCnx;
+   sigc::connection mRealizeCnx;
    sigc::trackable *mTrackable;
+   bool mSlotCalled;
    bool mWasMapped;
+
+   static unsigned long sSkippedResizes;
 };
 
 
@@ -0,0 +1,372 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * screenGeometry.cc --
+ *
+ *      A per-screen cache of monitor geometry for positioning popups.
+ */
+
+
+#include <algorithm>
+#include <gtkmmconfig.h>
+
+#include <libview/defines.h>
+#include <libview/screenGeometry.hh>
+
+
+#define SCREEN_GEOMETRY_KEY "libview-screen-geometry"
+
+
+namespace view {
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ScreenGeometry::Get --
+ *
+ *      Get the geometry cache of a screen, creating it on first use.
+ *      The cache lives as long as the screen does.
+ *
+ * Results:
+ *      The cache.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+ScreenGeometry &
+ScreenGeometry::Get(const Glib::RefPtr<Gdk::Screen> &screen) // IN
+{
+   GObject *object = G_OBJECT(screen->gobj());
+   ScreenGeometry *geometry = static_cast<ScreenGeometry *>(
+      g_object_get_data(object, SCREEN_GEOMETRY_KEY));
+
+   if (!geometry) {
+      geometry = new ScreenGeometry(screen.operator->());
+      g_object_set_data_full(object, SCREEN_GEOMETRY_KEY, geometry,
+                             &ScreenGeometry::OnDestroy);
+   }
+
+   return *geometry;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ScreenGeometry::ScreenGeometry --
+ *
+ *      Constructor.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+ScreenGeometry::ScreenGeometry(Gdk::Screen *screen) // IN
+   : mScreen(screen)
+{
+   mScreen->signal_size_changed().connect(
+      sigc::mem_fun(this, &ScreenGeometry::Refresh));
+#if GTKMM_CHECK_VERSION(2, 14, 0)
+   mScreen->signal_monitors_changed().connect(
+      sigc::mem_fun(this, &ScreenGeometry::Refresh));
+#endif
+
+   Refresh();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ScreenGeometry::OnDestroy --
+ *
+ *      Destroy notify for the cache attached to a screen.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ScreenGeometry::OnDestroy(gpointer data) // IN
+{
+   delete static_cast<ScreenGeometry *>(data);
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ScreenGeometry::Refresh --
+ *
+ *      Re-read the monitor geometry from the screen and rebuild the
+ *      lookup grid.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ScreenGeometry::Refresh(void)
+{
+   int nMonitors = mScreen->get_n_monitors();
+
+   mScreenRect = Gdk::Rectangle(0, 0, mScreen->get_width(),
+                                mScreen->get_height());
+   mMonitors.resize(nMonitors);
+   mXEdges.clear();
+   mYEdges.clear();
+
+   for (int i = 0; i < nMonitors; i++) {
+      Gdk::Rectangle &monitor = mMonitors[i];
+      mScreen->get_monitor_geometry(i, monitor);
+
+      mXEdges.push_back(monitor.get_x());
+      mXEdges.push_back(monitor.get_x() + monitor.get_width());
+      mYEdges.push_back(monitor.get_y());
+      mYEdges.push_back(monitor.get_y() + monitor.get_height());
+   }
+
+   std::sort(mXEdges.begin(), mXEdges.end());
+   mXEdges.erase(std::unique(mXEdges.begin(), mXEdges.end()), mXEdges.end());
+   std::sort(mYEdges.begin(), mYEdges.end());
+   mYEdges.erase(std::unique(mYEdges.begin(), mYEdges.end()), mYEdges.end());
+
+   int columns = std::max(static_cast<int>(mXEdges.size()) - 1, 0);
+   int rows = std::max(static_cast<int>(mYEdges.size()) - 1, 0);
+   mCells.assign(columns * rows, -1);
+
+   /*
+    * Fill in reverse so that, like GDK, the first monitor wins where
+    * monitors overlap (e.g. clone mode).
+    */
+   for (int i = nMonitors - 1; i >= 0; i--) {
+      const Gdk::Rectangle &monitor = mMonitors[i];
+      int left = FindCell(mXEdges, monitor.get_x());
+      int right = FindCell(mXEdges, monitor.get_x() + monitor.get_width());
+      int top = FindCell(mYEdges, monitor.get_y());
+      int bottom = FindCell(mYEdges, monitor.get_y() + monitor.get_height());
+
+      for (int row = top; row < bottom; row++) {
+         for (int column = left; column < right; column++) {
+            mCells[row * columns + column] = i;
+         }
+      }
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ScreenGeometry::FindCell --
+ *
+ *      Find the grid cell a co-ordinate falls in.
+ *
+ * Results:
+ *      The index of the last edge at or before value; -1 if value is
+ *      before the first edge, edges.size() - 1 if it is past the last.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+int
+ScreenGeometry::FindCell(const EdgeVector &edges, // IN
+                         int value)               // IN
+{
+   return std::upper_bound(edges.begin(), edges.end(), value)
+      - edges.begin() - 1;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ScreenGeometry::GetMonitorGeometry --
+ *
+ *      Get the cached geometry of a monitor.
+ *
+ * Results:
+ *      The monitor geometry, or the whole screen if GDK reported no
+ *      monitors.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+const Gdk::Rectangle &
+ScreenGeometry::GetMonitorGeometry(int monitor) // IN
+   const
+{
+   if (mMonitors.empty()) {
+      return mScreenRect;
+   }
+
+   g_return_val_if_fail(monitor >= 0 && monitor < GetNMonitors(),
+                        mMonitors[0]);
+
+   return mMonitors[monitor];
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ScreenGeometry::GetMonitorAtPoint --
+ *
+ *      Cached equivalent of Gdk::Screen::get_monitor_at_point.
+ *
+ * Results:
+ *      The monitor containing the point, or the nearest one if no
+ *      monitor does.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+int
+ScreenGeometry::GetMonitorAtPoint(int x, // IN
+                                  int y) // IN
+   const
+{
+   int column = FindCell(mXEdges, x);
+   int row = FindCell(mYEdges, y);
+   int columns = mXEdges.size() - 1;
+   int rows = mYEdges.size() - 1;
+
+   if (column >= 0 && column < columns && row >= 0 && row < rows) {
+      int monitor = mCells[row * columns + column];
+      if (monitor >= 0) {
+         return monitor;
+      }
+   }
+
+   return GetNearestMonitor(x, y);
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ScreenGeometry::GetMonitorGeometryAtPoint --
+ *
+ *      Convenience wrapper for the common popup positioning case.
+ *
+ * Results:
+ *      The geometry of the monitor at (or nearest to) the point.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+const Gdk::Rectangle &
+ScreenGeometry::GetMonitorGeometryAtPoint(int x, // IN
+                                          int y) // IN
+   const
+{
+   return GetMonitorGeometry(GetMonitorAtPoint(x, y));
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ScreenGeometry::GetNearestMonitor --
+ *
+ *      Find the monitor closest to a point that is not on any monitor.
+ *      This is rare enough that a linear scan is fine.
+ *
+ * Results:
+ *      The nearest monitor.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+int
+ScreenGeometry::GetNearestMonitor(int x, // IN
+                                  int y) // IN
+   const
+{
+   int nearest = 0;
+   int nearestDist = G_MAXINT;
+
+   for (int i = 0; i < GetNMonitors(); i++) {
+      const Gdk::Rectangle &monitor = mMonitors[i];
+      int right = monitor.get_x() + monitor.get_width();
+      int bottom = monitor.get_y() + monitor.get_height();
+      int dist = 0;
+
+      if (x < monitor.get_x()) {
+         dist += monitor.get_x() - x;
+      } else if (x >= right) {
+         dist += x - right + 1;
+      }
+
+      if (y < monitor.get_y()) {
+         dist += monitor.get_y() - y;
+      } else if (y >= bottom) {
+         dist += y - bottom + 1;
+      }
+
+      if (dist < nearestDist) {
+         nearest = i;
+         nearestDist = dist;
+      }
+   }
+
+   return nearest;
+}
+
+
+} // namespace view
@@ -0,0 +1,84 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * screenGeometry.hh --
+ *
+ *      A per-screen cache of monitor geometry for positioning popups.
+ *      It is refreshed only when the screen reports that its size or
+ *      monitors changed, and looks up the monitor at a point with a
+ *      binary search over the monitor edges.
+ */
+
+#ifndef LIBVIEW_SCREEN_GEOMETRY_HH
+#define LIBVIEW_SCREEN_GEOMETRY_HH
+
+
+#include <vector>
+#include <gdkmm/rectangle.h>
+#include <gdkmm/screen.h>
+
+
+namespace view {
+
+
+class ScreenGeometry
+   : public sigc::trackable
+{
+public:
+   static ScreenGeometry &Get(const Glib::RefPtr<Gdk::Screen> &screen);
+
+   int GetNMonitors(void) const { return mMonitors.size(); }
+   const Gdk::Rectangle &GetMonitorGeometry(int monitor) const;
+   int GetMonitorAtPoint(int x, int y) const;
+   const Gdk::Rectangle &GetMonitorGeometryAtPoint(int x, int y) const;
+
+private:
+   typedef std::vector<int> EdgeVector;
+
+   ScreenGeometry(Gdk::Screen *screen);
+
+   void Refresh(void);
+   int GetNearestMonitor(int x, int y) const;
+   static int FindCell(const EdgeVector &edges, int value);
+   static void OnDestroy(gpointer data);
+
+   Gdk::Screen *mScreen;
+   Gdk::Rectangle mScreenRect;
+   std::vector<Gdk::Rectangle> mMonitors;
+
+   /*
+    * The sorted, distinct left/right and top/bottom edges of all monitors
+    * cut the screen into a grid; mCells holds the monitor covering each
+    * cell, or -1.
+    */
+   EdgeVector mXEdges;
+   EdgeVector mYEdges;
+   std::vector<int> mCells;
+};
+
+
+} // namespace view
+
+
+#endif // LIBVIEW_SCREEN_GEOMETRY_HH
@@ -35,6 +35,9 @@
  */
 
 
+#include <algorithm>
+#include <gtkmm/iconsource.h>
+
 #include <libview/spinner.hh>
 
 
@@ -46,7 +49,8 @@ namespace view {
  *
  * view::Spinner::Spinner --
  *
- *      Constructor. See SetFrames for parameter rationale.
+ *      Constructor. See SetFrames for parameter rationale. If an atlas
+ *      holding the same frames is given, frames are drawn from it.
  *
  * Results:
  *      None
@@ -58,8 +62,16 @@ namespace view {
  */
 
 Spinner::Spinner(FrameVector &frames,                 // IN
-                 Glib::RefPtr<Gdk::Pixbuf> restFrame) // IN
-   : Gtk::Image()
+                 Glib::RefPtr<Gdk::Pixbuf> restFrame, // IN
+                 FrameAtlas *atlas)                   // IN/OPT
+   : Gtk::Image(),
+     mAtlas(atlas),
+     mFrameWidth(0),
+     mFrameHeight(0),
+     mResizeCount(0),
+     mShowing(false),
+     mObscured(false),
+     mIconified(false)
 {
    SetFrames(frames, restFrame);
 }
@@ -81,7 +93,8 @@ Spinner::Spinner(FrameVector &frames,                 // IN
  *      None
  *
  * Side effects:
- *      Spinner will be reset to the rest frame.
+ *      Spinner will be reset to the rest frame. A resize is queued if
+ *      the frame size changed.
  *
  *-------------------------------------------------------------------
  */
@@ -93,10 +106,53 @@ Spinner::SetFrames(FrameVector &frames,                 // IN
    mFrames = &frames;
    mRestFrame = restFrame;
 
+   UpdateFrameSize();
    Rest();
 }
 
 
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::Spinner::UpdateFrameSize --
+ *
+ *      Recompute the size of the largest frame, which is what we
+ *      request, and queue a resize only if it changed.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+Spinner::UpdateFrameSize(void)
+{
+   int width = 0;
+   int height = 0;
+
+   if (mRestFrame) {
+      width = mRestFrame->get_width();
+      height = mRestFrame->get_height();
+   }
+
+   for (FrameVector::size_type i = 0; i < mFrames->size(); i++) {
+      width = std::max(width, (*mFrames)[i]->get_width());
+      height = std::max(height, (*mFrames)[i]->get_height());
+   }
+
+   if (width != mFrameWidth || height != mFrameHeight) {
+      mFrameWidth = width;
+      mFrameHeight = height;
+      mResizeCount++;
+      queue_resize();
+   }
+}
+
+
 /*
  *-------------------------------------------------------------------
  *
@@ -113,7 +169,7 @@ Spinner::SetFrames(FrameVector &frames,                 // IN
  *      None
  *
  * Side effects:
- *      None
+ *      Only the spinner's own area is redrawn, and only if showing.
  *
  *-------------------------------------------------------------------
  */
@@ -127,7 +183,42 @@ Spinner::Advance(void)
       if (static_cast<unsigned int>(++mCurrentFrame) >= mFrames->size()) {
          mCurrentFrame = 0;
       }
-      set((*mFrames)[mCurrentFrame]);
+      Redraw();
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::Spinner::SetFrame --
+ *
+ *      Show the frame for the given animation step, wrapping around
+ *      the frame sequence. Used by the action to keep all proxies in
+ *      step and to catch up spinners that were not showing.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Only the spinner's own area is redrawn, and only if showing and
+ *      the frame changed.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+Spinner::SetFrame(unsigned long step) // IN
+{
+   if (mFrames->empty()) {
+      Rest();
+      return;
+   }
+
+   FrameVector::size_type frame = step % mFrames->size();
+   if (frame != mCurrentFrame) {
+      mCurrentFrame = frame;
+      Redraw();
    }
 }
 
@@ -143,7 +234,7 @@ Spinner::Advance(void)
  *      None
  *
  * Side effects:
- *      None
+ *      Only the spinner's own area is redrawn, and only if showing.
  *
  *-------------------------------------------------------------------
  */
@@ -152,7 +243,306 @@ void
 Spinner::Rest(void)
 {
    mCurrentFrame = static_cast<FrameVector::size_type>(-1);
-   set(mRestFrame);
+   Redraw();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::Spinner::Redraw --
+ *
+ *      Queue a redraw for a frame change, unless nobody can see it.
+ *      UpdateShowing() redraws when the spinner shows again.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+Spinner::Redraw(void)
+{
+   if (mShowing) {
+      queue_draw();
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::Spinner::UpdateShowing --
+ *
+ *      Recompute whether the spinner can be seen, and tell listeners
+ *      when that changes.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Emits showingChanged. Redraws when the spinner shows again.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+Spinner::UpdateShowing(void)
+{
+   bool showing = is_mapped() && !mObscured && !mIconified;
+   if (showing == mShowing) {
+      return;
+   }
+
+   mShowing = showing;
+   showingChanged.emit(showing);
+   if (mShowing) {
+      queue_draw();
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::Spinner::on_map --
+ * view::Spinner::on_unmap --
+ *
+ *      "map" and "unmap" methods of a Spinner. Hidden toolbars and
+ *      overflowed tool items unmap us.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      See UpdateShowing().
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+Spinner::on_map(void)
+{
+   Gtk::Image::on_map();
+   UpdateShowing();
+}
+
+
+void
+Spinner::on_unmap(void)
+{
+   Gtk::Image::on_unmap();
+   UpdateShowing();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::Spinner::on_hierarchy_changed --
+ *
+ *      "hierarchy_changed" method of a Spinner. We have no window of
+ *      our own to get visibility events on, so we follow those of our
+ *      toplevel, along with its iconified state.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Adds GDK_VISIBILITY_NOTIFY_MASK to the toplevel's events.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+Spinner::on_hierarchy_changed(Gtk::Widget *previousToplevel) // IN
+{
+   Gtk::Image::on_hierarchy_changed(previousToplevel);
+
+   mVisibilityConnection.disconnect();
+   mWindowStateConnection.disconnect();
+   mObscured = false;
+   mIconified = false;
+
+   Gtk::Window *toplevel = dynamic_cast<Gtk::Window *>(get_toplevel());
+   if (toplevel) {
+      toplevel->add_events(Gdk::VISIBILITY_NOTIFY_MASK);
+      mVisibilityConnection = toplevel->signal_visibility_notify_event().connect(
+         sigc::mem_fun(this, &Spinner::OnToplevelVisibility));
+      mWindowStateConnection = toplevel->signal_window_state_event().connect(
+         sigc::mem_fun(this, &Spinner::OnToplevelWindowState));
+
+      Glib::RefPtr<Gdk::Window> window = toplevel->get_window();
+      mIconified = window
+         && (window->get_state() & Gdk::WINDOW_STATE_ICONIFIED) != 0;
+   }
+
+   UpdateShowing();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::Spinner::OnToplevelVisibility --
+ * view::Spinner::OnToplevelWindowState --
+ *
+ *      Handlers for our toplevel's "visibility_notify_event" and
+ *      "window_state_event" signals.
+ *
+ * Results:
+ *      false to let others see the event.
+ *
+ * Side effects:
+ *      See UpdateShowing().
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+Spinner::OnToplevelVisibility(GdkEventVisibility *event) // IN
+{
+   mObscured = event->state == GDK_VISIBILITY_FULLY_OBSCURED;
+   UpdateShowing();
+   return false;
+}
+
+
+bool
+Spinner::OnToplevelWindowState(GdkEventWindowState *event) // IN
+{
+   mIconified = (event->new_window_state & GDK_WINDOW_STATE_ICONIFIED) != 0;
+   UpdateShowing();
+   return false;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::Spinner::GetCurrentFrame --
+ *
+ *      Get the frame that should currently be shown.
+ *
+ * Results:
+ *      The current frame, the rest frame, or NULL if there is neither.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+Glib::RefPtr<Gdk::Pixbuf>
+Spinner::GetCurrentFrame(void)
+   const
+{
+   if (mCurrentFrame < mFrames->size()) {
+      return (*mFrames)[mCurrentFrame];
+   }
+   return mRestFrame;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::Spinner::on_size_request --
+ *
+ *      "size_request" method of a Spinner. We request room for the
+ *      largest frame, so the requisition never changes from frame to
+ *      frame.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+Spinner::on_size_request(Gtk::Requisition *requisition) // OUT
+{
+   int xpad;
+   int ypad;
+   get_padding(xpad, ypad);
+
+   requisition->width = mFrameWidth + 2 * xpad;
+   requisition->height = mFrameHeight + 2 * ypad;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::Spinner::on_expose_event --
+ *
+ *      Expose event handler. Paint the current frame, aligned and
+ *      padded the way Gtk::Image would. Frames are copied from the
+ *      server-side atlas when we have one; otherwise, or when the frame
+ *      must be rendered for a non-normal state, the pixbuf is drawn.
+ *
+ * Results:
+ *      true - we don't chain up, as the Gtk::Image has nothing to draw.
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+bool
+Spinner::on_expose_event(GdkEventExpose *event) // IN
+{
+   Glib::RefPtr<Gdk::Pixbuf> frame = GetCurrentFrame();
+   if (!frame || !is_drawable()) {
+      return true;
+   }
+
+   const Gtk::Allocation allocation(get_allocation());
+   float xalign;
+   float yalign;
+   int xpad;
+   int ypad;
+   get_alignment(xalign, yalign);
+   get_padding(xpad, ypad);
+   if (get_direction() == Gtk::TEXT_DIR_RTL) {
+      xalign = 1.0 - xalign;
+   }
+
+   int x = allocation.get_x() + xpad +
+      static_cast<int>((allocation.get_width() - 2 * xpad
+                        - frame->get_width()) * xalign);
+   int y = allocation.get_y() + ypad +
+      static_cast<int>((allocation.get_height() - 2 * ypad
+                        - frame->get_height()) * yalign);
+
+   if (get_state() == Gtk::STATE_NORMAL) {
+      // The rest frame is stored after the animation frames.
+      int index = mCurrentFrame < mFrames->size() ? mCurrentFrame
+                                                  : mFrames->size();
+      if (mAtlas && mAtlas->Draw(*this, index, x, y)) {
+         return true;
+      }
+   } else {
+      Gtk::IconSource source;
+      source.set_pixbuf(frame);
+      source.set_size_wildcarded(true);
+      frame = get_style()->render_icon(source, get_direction(), get_state(),
+                                       Gtk::IconSize(-1), *this, "");
+   }
+
+   get_window()->draw_pixbuf(get_style()->get_black_gc(), frame,
+                             0, 0, x, y,
+                             frame->get_width(), frame->get_height(),
+                             Gdk::RGB_DITHER_NORMAL, 0, 0);
+   return true;
 }
 
 
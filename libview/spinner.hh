@@ -32,6 +32,16 @@
  *      So, the widget only defines the mechanics of switching frames.
  *      Loading the frames and setting an animation policy is left to the
  *      action.
+ *
+ *      The spinner paints the current frame itself rather than calling
+ *      Gtk::Image::set, which would reset the image and queue a resize of
+ *      the whole toolbar on every frame. Its requisition is the size of
+ *      the largest frame and only changes when the frames do.
+ *
+ *      A spinner that is unmapped, or whose toplevel is iconified or fully
+ *      obscured, is not showing: frame changes only move the frame index
+ *      and paint nothing. showingChanged lets the action skip such
+ *      spinners and bring them back to the right frame on re-show.
  */
 
 #ifndef LIBVIEW_SPINNER_HH
@@ -39,8 +49,11 @@
 
 
 #include <gtkmm/image.h>
+#include <gtkmm/window.h>
 #include <gdkmm/pixbuf.h>
 
+#include <libview/frameAtlas.hh>
+
 
 namespace view {
 
@@ -51,18 +64,51 @@ class Spinner
 public:
    typedef std::vector<Glib::RefPtr<Gdk::Pixbuf> > FrameVector;
 
-   Spinner(FrameVector &frames, Glib::RefPtr<Gdk::Pixbuf> restFrame);
+   Spinner(FrameVector &frames, Glib::RefPtr<Gdk::Pixbuf> restFrame,
+           FrameAtlas *atlas = NULL);
 
    void SetFrames(FrameVector &frames, Glib::RefPtr<Gdk::Pixbuf> restFrame);
 
    void Advance(void);
    void Rest(void);
+   void SetFrame(unsigned long step);
+
+   bool IsShowing(void) const { return mShowing; }
+   unsigned int GetResizeCount(void) const { return mResizeCount; }
+
+   sigc::signal<void, bool /* showing */> showingChanged;
+
+protected:
+   void on_size_request(Gtk::Requisition *requisition);
+   bool on_expose_event(GdkEventExpose *event);
+   void on_map(void);
+   void on_unmap(void);
+   void on_hierarchy_changed(Gtk::Widget *previousToplevel);
 
 private:
+   Glib::RefPtr<Gdk::Pixbuf> GetCurrentFrame(void) const;
+   void UpdateFrameSize(void);
+   void UpdateShowing(void);
+   void Redraw(void);
+
+   bool OnToplevelVisibility(GdkEventVisibility *event);
+   bool OnToplevelWindowState(GdkEventWindowState *event);
+
    const FrameVector *mFrames;
    Glib::RefPtr<Gdk::Pixbuf> mRestFrame;
+   FrameAtlas *mAtlas;
 
    FrameVector::size_type mCurrentFrame;
+
+   int mFrameWidth;
+   int mFrameHeight;
+   unsigned int mResizeCount;
+
+   bool mShowing;
+   bool mObscured;
+   bool mIconified;
+   sigc::connection mVisibilityConnection;
+   sigc::connection mWindowStateConnection;
 };
 
 
@@ -29,6 +29,13 @@
  *      frames and propagating frame changes to all proxy widgets. Policy
  *      for when to change frames is left up to consumers/subclasses of the
  *      action.
+ *
+ *      Only the rest frame is loaded up front. The animation frames are
+ *      decoded and scaled on a worker thread the first time the spinner
+ *      is advanced and installed from the main loop, so neither startup
+ *      nor icon theme changes wait on image decoding. Frames come from
+ *      the process-wide FrameCache and are shared with every other
+ *      action showing the same asset at the same size.
  */
 
 
@@ -69,7 +76,13 @@ SpinnerAction::SpinnerAction(const Glib::ustring &name,              // IN
      mFrameIDs(frameIDs),
      mRestID(restID),
      mIconTheme(iconTheme),
-     mRestSize(0)
+     mRestSize(0),
+     mRestEntry(NULL),
+     mFramesLoaded(false),
+     mLoadPending(false),
+     mSpinning(false),
+     mStep(0),
+     mShowingSpinners(0)
 {
    Gtk::IconSize::lookup(iconSize, mTargetW, mTargetH);
 
@@ -79,6 +92,32 @@ SpinnerAction::SpinnerAction(const Glib::ustring &name,              // IN
 }
 
 
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::SpinnerAction::~SpinnerAction --
+ *
+ *      Destructor. Gives the cached frames back to the FrameCache.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Frames no other action uses are freed.
+ *
+ *-------------------------------------------------------------------
+ */
+
+SpinnerAction::~SpinnerAction()
+{
+   DisconnectLoaded();
+   for (EntryVector::size_type i = 0; i < mFrameEntries.size(); i++) {
+      FrameCache::Release(mFrameEntries[i]);
+   }
+   FrameCache::Release(mRestEntry);
+}
+
+
 /*
  *-------------------------------------------------------------------
  *
@@ -144,7 +183,10 @@ SpinnerAction::create_tool_item_vfunc(void)
    alignment->show();
    item->add(*alignment);
 
-   Spinner *spinner = Gtk::manage(new Spinner(mFrames, mRestFrame));
+   Spinner *spinner = Gtk::manage(new Spinner(mFrames, mRestFrame, &mAtlas));
+   spinner->showingChanged.connect(
+      sigc::bind(sigc::mem_fun(this, &SpinnerAction::OnSpinnerShowingChanged),
+                 spinner));
    spinner->show();
    alignment->add(*spinner);
 
@@ -157,22 +199,17 @@ SpinnerAction::create_tool_item_vfunc(void)
  *
  * view::SpinnerAction::LoadAllFrames --
  *
- *      Load the animation frames and set them onto each proxy widget.
- *
- *      It may seem slightly ridiculous to have an algorithm that
- *      could handle a list of stockIDs where each stockID represented
- *      multiple frames but this is to maximise reusability. It is
- *      instead much more likely that either an icon-theme style spinner,
- *      with one stockID containing multiple frames *or* a sane spinner,
- *      where each frame is stored separately would be used. But it's
- *      cleaner to merge both loading paths than to try and special
- *      case.
+ *      Load the rest frame and set it onto each proxy widget. The
+ *      animation frames are only (re)loaded if they have been needed
+ *      before; otherwise that is left to the first Advance().
  *
  * Results:
  *      None
  *
  * Side effects:
- *      Proxies will update and redraw.
+ *      Proxies will update and redraw. The frames are uploaded to the X
+ *      server again the next time they are drawn. May start loads on
+ *      the FrameCache worker pool.
  *
  *-------------------------------------------------------------------
  */
@@ -180,21 +217,32 @@ SpinnerAction::create_tool_item_vfunc(void)
 void
 SpinnerAction::LoadAllFrames(void)
 {
-   mFrames.clear();
-
    Gtk::IconInfo info = mIconTheme->lookup_icon(mRestID, -1,
                                                 (Gtk::IconLookupFlags)0);
    if (info.gobj()) {
-      Glib::RefPtr<Gdk::Pixbuf> buffer = 
-         Gdk::Pixbuf::create_from_file(info.get_filename());
-      mRestSize = buffer->get_width();
-      mRestFrame = buffer->scale_simple(mTargetW, mTargetH, Gdk::INTERP_BILINEAR);
+      FrameCache::Entry *entry =
+         FrameCache::Acquire(info.get_filename(), 0, mTargetW, mTargetH);
+      FrameCache::Release(mRestEntry);
+      mRestEntry = entry;
+
+      FrameCache::Load(mRestEntry);
+      if (!mRestEntry->GetFrames().empty()) {
+         mRestSize = mRestEntry->GetSourceWidth();
+         mRestFrame = mRestEntry->GetFrames()[0];
+      }
    }
 
-   for (FrameIDVector::size_type i = 0; i < mFrameIDs.size(); i++) {
-      LoadFrames(mFrameIDs[i]);
+   /*
+    * Frames from the old theme keep animating until the new ones
+    * arrive, rather than dropping the spinner back to rest mid-spin:
+    * mFrames is only replaced in OnFramesLoaded(), and handing the
+    * proxies the new rest frame below keeps them on their current step.
+    */
+   if (mFramesLoaded || mLoadPending) {
+      StartLoad();
    }
 
+   mAtlas.SetFrames(mFrames, mRestFrame);
    ForeachSpinner(sigc::mem_fun(this, &SpinnerAction::SpinnerSetFrames));
 }
 
@@ -202,29 +250,41 @@ SpinnerAction::LoadAllFrames(void)
 /*
  *-------------------------------------------------------------------
  *
- * view::SpinnerAction::LoadFrames --
+ * view::SpinnerAction::StartLoad --
  *
- *      Load the frames from the passed stockID and append them to
- *      our frame vector.
+ *      Look up the animation frames in the FrameCache and queue any
+ *      that aren't loaded yet on its worker pool. Frames already in
+ *      the cache are installed straight away.
+ *
+ *      It may seem slightly ridiculous to have an algorithm that
+ *      could handle a list of stockIDs where each stockID represented
+ *      multiple frames but this is to maximise reusability. It is
+ *      instead much more likely that either an icon-theme style spinner,
+ *      with one stockID containing multiple frames *or* a sane spinner,
+ *      where each frame is stored separately would be used. But it's
+ *      cleaner to merge both loading paths than to try and special
+ *      case.
  *
  * Results:
  *      None
  *
  * Side effects:
- *      None
+ *      See OnFramesLoaded().
  *
  *-------------------------------------------------------------------
  */
 
 void
-SpinnerAction::LoadFrames(const Glib::ustring &frameID) // IN
+SpinnerAction::StartLoad(void)
 {
-   Gtk::IconInfo info = mIconTheme->lookup_icon(frameID, -1,
-                                                (Gtk::IconLookupFlags)0);
+   EntryVector entries;
 
-   if (info.gobj()) {
-      Glib::RefPtr<Gdk::Pixbuf> buffer = 
-         Gdk::Pixbuf::create_from_file(info.get_filename());
+   for (FrameIDVector::size_type i = 0; i < mFrameIDs.size(); i++) {
+      Gtk::IconInfo info = mIconTheme->lookup_icon(mFrameIDs[i], -1,
+                                                   (Gtk::IconLookupFlags)0);
+      if (!info.gobj()) {
+         continue;
+      }
 
       /*
        * By convention, the spinner animation is stored as a sequence of frames
@@ -241,15 +301,106 @@ SpinnerAction::LoadFrames(const Glib::ustring &frameID) // IN
       if (frameSize <= 0) {
          frameSize = mRestSize;
       }
+      if (frameSize <= 0) {
+         continue;
+      }
+
+      entries.push_back(FrameCache::Acquire(info.get_filename(), frameSize,
+                                            mTargetW, mTargetH));
+   }
 
-      for (int y = 0; buffer->get_height() - y >= frameSize; y += frameSize) {
-         for (int x = 0; buffer->get_width() - x >= frameSize; x += frameSize) {
-            mFrames.push_back(
-               Gdk::Pixbuf::create_subpixbuf(buffer, x, y, frameSize, frameSize)->
-                  scale_simple(mTargetW, mTargetH, Gdk::INTERP_BILINEAR));
-         }
+   /*
+    * Acquire before releasing, so entries the theme change didn't
+    * touch stay in the cache and aren't decoded again.
+    */
+   DisconnectLoaded();
+   for (EntryVector::size_type i = 0; i < mFrameEntries.size(); i++) {
+      FrameCache::Release(mFrameEntries[i]);
+   }
+   mFrameEntries.swap(entries);
+   mLoadPending = true;
+
+   for (EntryVector::size_type i = 0; i < mFrameEntries.size(); i++) {
+      FrameCache::Entry *entry = mFrameEntries[i];
+      if (!entry->IsLoaded()) {
+         mLoadedConnections.push_back(entry->loaded.connect(
+            sigc::mem_fun(this, &SpinnerAction::OnFramesLoaded)));
+         FrameCache::LoadAsync(entry);
       }
    }
+
+   OnFramesLoaded();
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::SpinnerAction::OnFramesLoaded --
+ *
+ *      Once every pending FrameCache entry is loaded, gather their
+ *      frames and set them onto each proxy widget.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Proxies will update and redraw.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+SpinnerAction::OnFramesLoaded(void)
+{
+   if (!mLoadPending) {
+      return;
+   }
+   for (EntryVector::size_type i = 0; i < mFrameEntries.size(); i++) {
+      if (!mFrameEntries[i]->IsLoaded()) {
+         return;
+      }
+   }
+
+   mLoadPending = false;
+   DisconnectLoaded();
+
+   mFrames.clear();
+   for (EntryVector::size_type i = 0; i < mFrameEntries.size(); i++) {
+      const FrameVector &frames = mFrameEntries[i]->GetFrames();
+      mFrames.insert(mFrames.end(), frames.begin(), frames.end());
+   }
+   mFramesLoaded = true;
+
+   mAtlas.SetFrames(mFrames, mRestFrame);
+   ForeachSpinner(sigc::mem_fun(this, &SpinnerAction::SpinnerSetFrames));
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::SpinnerAction::DisconnectLoaded --
+ *
+ *      Stop listening for FrameCache entries to finish loading.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+SpinnerAction::DisconnectLoaded(void)
+{
+   for (std::vector<sigc::connection>::size_type i = 0;
+        i < mLoadedConnections.size(); i++) {
+      mLoadedConnections[i].disconnect();
+   }
+   mLoadedConnections.clear();
 }
 
 
@@ -258,13 +409,19 @@ SpinnerAction::LoadFrames(const Glib::ustring &frameID) // IN
  *
  * view::SpinnerAction::Advance --
  *
- *      Advance each proxy spinner widget forward one frame.
+ *      Advance each proxy spinner widget forward one frame. The
+ *      first call starts loading the animation frames; until they
+ *      arrive the spinners stay on the rest frame.
+ *
+ *      Spinners that aren't showing are left alone; they catch up in
+ *      OnSpinnerShowingChanged(). With none showing, this is just a
+ *      counter increment.
  *
  * Results:
  *      None
  *
  * Side effects:
- *      None.
+ *      May start loads on the FrameCache worker pool.
  *
  *-------------------------------------------------------------------
  */
@@ -272,7 +429,19 @@ SpinnerAction::LoadFrames(const Glib::ustring &frameID) // IN
 void
 SpinnerAction::Advance(void)
 {
-   ForeachSpinner(sigc::ptr_fun(&SpinnerAction::SpinnerAdvance));
+   if (!mFramesLoaded) {
+      if (!mLoadPending) {
+         StartLoad();
+      }
+      return;
+   }
+
+   mStep = mSpinning ? mStep + 1 : 0;
+   mSpinning = true;
+
+   if (mShowingSpinners > 0) {
+      ForeachSpinner(sigc::mem_fun(this, &SpinnerAction::SpinnerSetFrame));
+   }
 }
 
 
@@ -282,6 +451,7 @@ SpinnerAction::Advance(void)
  * view::SpinnerAction::Rest --
  *
  *      Reset each proxy spinner widget back to the rest frame.
+ *      As with Advance(), spinners that aren't showing catch up later.
  *
  * Results:
  *      None
@@ -295,7 +465,47 @@ SpinnerAction::Advance(void)
 void
 SpinnerAction::Rest(void)
 {
-   ForeachSpinner(sigc::ptr_fun(&SpinnerAction::SpinnerRest));
+   mSpinning = false;
+
+   if (mShowingSpinners > 0) {
+      ForeachSpinner(sigc::ptr_fun(&SpinnerAction::SpinnerRest));
+   }
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::SpinnerAction::OnSpinnerShowingChanged --
+ *
+ *      Handler for a proxy spinner's showingChanged signal. Keeps
+ *      count of the spinners that can be seen, and brings a spinner
+ *      that shows again straight to the current frame.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+SpinnerAction::OnSpinnerShowingChanged(bool showing,     // IN
+                                       Spinner *spinner) // IN
+{
+   if (!showing) {
+      mShowingSpinners--;
+      return;
+   }
+
+   mShowingSpinners++;
+   if (mSpinning) {
+      spinner->SetFrame(mStep);
+   } else {
+      spinner->Rest();
+   }
 }
 
 
@@ -339,11 +549,13 @@ SpinnerAction::ForeachSpinner(sigc::slot<void, Spinner *> functor) // IN
 /*
  *-------------------------------------------------------------------
  *
- * view::SpinnerAction::SpinnerAdvance --
+ * view::SpinnerAction::SpinnerSetFrame --
  * view::SpinnerAction::SpinnerRest --
  * view::SpinnerAction::SpinnerSetFrames --
  *
- *      Helpers to call methods on a spinner widget. Required because
+ *      Helpers to call methods on a spinner widget. Spinner::SetFrames
+ *      resets a spinner to rest, so SpinnerSetFrames puts a spinning
+ *      one back on the current step. Required because
  *      libsigc++ isn't powerful enough to create mem_fun slots where
  *      the object is specified later as a parameter. I've declared
  *      them inline, but I doubt that the compiler can inline them
@@ -360,9 +572,9 @@ SpinnerAction::ForeachSpinner(sigc::slot<void, Spinner *> functor) // IN
  */
 
 inline void
-SpinnerAction::SpinnerAdvance(Spinner *spinner) // IN
+SpinnerAction::SpinnerSetFrame(Spinner *spinner) // IN
 {
-   spinner->Advance();
+   spinner->SetFrame(mStep);
 }
 
 
@@ -377,6 +589,9 @@ inline void
 SpinnerAction::SpinnerSetFrames(Spinner *spinner) // IN
 {
    spinner->SetFrames(mFrames, mRestFrame);
+   if (mSpinning) {
+      spinner->SetFrame(mStep);
+   }
 }
 
 
@@ -39,6 +39,9 @@
 #include <gtkmm/icontheme.h>
 #include <gtkmm/toolitem.h>
 
+#include <libview/frameAtlas.hh>
+#include <libview/frameCache.hh>
+
 
 namespace view {
 
@@ -58,6 +61,8 @@ public:
                                              const Glib::ustring &restID,
                                              Glib::RefPtr<Gtk::IconTheme> iconTheme);
 
+   ~SpinnerAction();
+
    void Advance(void);
    void Rest(void);
 
@@ -72,14 +77,18 @@ protected:
 
 private:
    typedef std::vector<Glib::RefPtr<Gdk::Pixbuf> > FrameVector;
+   typedef std::vector<FrameCache::Entry *> EntryVector;
 
    void LoadAllFrames(void);
-   void LoadFrames(const Glib::ustring &frameID);
+   void StartLoad(void);
+   void OnFramesLoaded(void);
+   void DisconnectLoaded(void);
 
    void ForeachSpinner(sigc::slot<void, Spinner *> functor);
    void SpinnerSetFrames(Spinner *spinner);
-   static void SpinnerAdvance(Spinner *spinner);
+   void SpinnerSetFrame(Spinner *spinner);
    static void SpinnerRest(Spinner *spinner);
+   void OnSpinnerShowingChanged(bool showing, Spinner *spinner);
    static Spinner *GetSpinnerFromItem(Gtk::ToolItem *item);
 
    static bool OnToolItemCreateMenuProxy(Gtk::ToolItem *item);
@@ -89,11 +98,22 @@ private:
 
    FrameVector mFrames;
    Glib::RefPtr<Gdk::Pixbuf> mRestFrame;
+   FrameAtlas mAtlas;
 
    Glib::RefPtr<Gtk::IconTheme> mIconTheme;
    int mTargetW;
    int mTargetH;
    int mRestSize;
+
+   FrameCache::Entry *mRestEntry;
+   EntryVector mFrameEntries;
+   std::vector<sigc::connection> mLoadedConnections;
+   bool mFramesLoaded;
+   bool mLoadPending;
+
+   bool mSpinning;
+   unsigned long mStep;
+   int mShowingSpinners;
 };
 
 } // namespace view
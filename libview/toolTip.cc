@@ -28,14 +28,16 @@
  */
 
 
-#include <gtkmm/label.h>
-
+#include <libview/screenGeometry.hh>
 #include <libview/toolTip.hh>
 
 
 namespace view {
 
 
+std::vector<ToolTip *> ToolTip::sPool;
+
+
 /*
  *-------------------------------------------------------------------
  *
@@ -55,8 +57,10 @@ namespace view {
 ToolTip::ToolTip(Gtk::Widget &target,         // IN
                  const Glib::ustring &markup) // IN
    : Gtk::Window(Gtk::WINDOW_POPUP),
-     mTarget(target),
-     mTracker(target)
+     mTarget(&target),
+     mLabel(Gtk::manage(new Gtk::Label())),
+     mTracker(target),
+     mPaintedPixels(0)
 {
    // This is how a GtkTooltip window is set up.
    set_app_paintable(true);
@@ -67,29 +71,129 @@ ToolTip::ToolTip(Gtk::Widget &target,         // IN
    // We need to intercept this to allow us to delete the tooltip when clicked.
    add_events(Gdk::BUTTON_PRESS_MASK);
 
-   Gtk::Label *label = Gtk::manage(new Gtk::Label());
-   label->show();
-   add(*label);
-   label->set_markup(markup);
-   label->set_line_wrap(true);
-   label->set_alignment(0.5, 0.5);
+   mLabel->show();
+   add(*mLabel);
+   mLabel->set_markup(markup);
+   mLabel->set_line_wrap(true);
+   mLabel->set_alignment(0.5, 0.5);
 
    mTracker.connect(sigc::mem_fun(this, &ToolTip::UpdatePosition));
 }
 
 
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ToolTip::Show --
+ *
+ *      Show a tip for a widget, reusing a pooled tip window if one is
+ *      available. The tip hides itself like any other ToolTip.
+ *
+ * Results:
+ *      The tip being shown. It is owned by the pool.
+ *
+ * Side effects:
+ *      A new tip is created if the pool is empty.
+ *
+ *-------------------------------------------------------------------
+ */
+
+ToolTip *
+ToolTip::Show(Gtk::Widget &target,         // IN
+              const Glib::ustring &markup) // IN
+{
+   ToolTip *tip;
+
+   if (sPool.empty()) {
+      tip = new ToolTip(target, markup);
+   } else {
+      tip = sPool.back();
+      sPool.pop_back();
+      tip->SetTip(target, markup);
+   }
+
+   tip->show();
+   return tip;
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ToolTip::SetTip --
+ *
+ *      Point a pooled tip at a new target and text.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The window is moved to the target's screen, which unrealizes it
+ *      if that is a different screen.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ToolTip::SetTip(Gtk::Widget &target,         // IN
+                const Glib::ustring &markup) // IN
+{
+   mTarget = &target;
+   mTracker.SetTarget(mTarget);
+   mLabel->set_markup(markup);
+
+   // The last target may have been on another screen.
+   set_screen(target.get_screen());
+}
+
+
+/*
+ *-------------------------------------------------------------------
+ *
+ * view::ToolTip::Release --
+ *
+ *      Hide the tip and return it to the pool. The window stays
+ *      realized so the next tip shown doesn't have to create it again.
+ *      Tips beyond what the pool keeps are deleted.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Widget may be deleted.
+ *
+ *-------------------------------------------------------------------
+ */
+
+void
+ToolTip::Release(void)
+{
+   mTimeout.disconnect();
+   hide();
+
+   mTracker.SetTarget(NULL);
+   mTarget = NULL;
+
+   if (sPool.size() < sMaxPooled) {
+      sPool.push_back(this);
+   } else {
+      delete this;
+   }
+}
+
+
 /*
  *-------------------------------------------------------------------
  *
  * view::ToolTip::on_button_press_event --
  *
- *      Button press event handler. Deletes the tip.
+ *      Button press event handler. Releases the tip.
  *
  * Results:
  *      true - event is handled.
  *
  * Side effects:
- *      Widget is deleted.
+ *      Widget is hidden and may be deleted.
  *
  *-------------------------------------------------------------------
  */
@@ -99,7 +203,7 @@ ToolTip::on_button_press_event(GdkEventButton *event) // IN
 {
    Gtk::Window::on_button_press_event(event);
 
-   delete this;
+   Release();
    return true;
 }
 
@@ -109,7 +213,8 @@ ToolTip::on_button_press_event(GdkEventButton *event) // IN
  *
  * view::ToolTip::on_expose_event --
  *
- *      Expose event handler. Paint the window like a tooltip.
+ *      Expose event handler. Paint the window like a tooltip, clipped
+ *      to the exposed area.
  *
  * Results:
  *      Result of parent handler.
@@ -130,20 +235,27 @@ ToolTip::on_expose_event(GdkEventExpose *event) // IN
     * the window manager should never prevent the tooltip's window
     * being allocated at the requested size. But if we ever see
     * problems related to that, you know what to do. :-) --plangdale
+    *
+    * The request was computed when the tip was shown, so there is no
+    * need to ask for it again on every expose.
     */
-   Gtk::Requisition req;
-   size_request(req);
-
-   get_style()->paint_flat_box(get_window(),
-                               Gtk::STATE_NORMAL,
-                               Gtk::SHADOW_OUT,
-                               Gdk::Rectangle(),
-                               *this,
-                               "tooltip",
-                               0,
-                               0,
-                               req.width,
-                               req.height);
+   Gtk::Requisition req = get_requisition();
+
+   GdkRectangle box = { 0, 0, req.width, req.height };
+   GdkRectangle area;
+   if (gdk_rectangle_intersect(&event->area, &box, &area)) {
+      get_style()->paint_flat_box(get_window(),
+                                  Gtk::STATE_NORMAL,
+                                  Gtk::SHADOW_OUT,
+                                  Gdk::Rectangle(&area),
+                                  *this,
+                                  "tooltip",
+                                  0,
+                                  0,
+                                  req.width,
+                                  req.height);
+      mPaintedPixels += area.width * area.height;
+   }
 
    return Gtk::Window::on_expose_event(event);
 }
@@ -154,13 +266,13 @@ ToolTip::on_expose_event(GdkEventExpose *event) // IN
  *
  * view::ToolTip::on_show --
  *
- *      Show event handler. Timer is set to delete widget later.
+ *      Show event handler. Timer is set to release widget later.
  *
  * Results:
  *      None
  *
  * Side effects:
- *      Widget will be deleted by timeout later.
+ *      Widget will be released by timeout later.
  *
  *-------------------------------------------------------------------
  */
@@ -172,7 +284,8 @@ ToolTip::on_show(void)
 
    Gtk::Window::on_show();
 
-   Glib::signal_timeout().connect(
+   mTimeout.disconnect();
+   mTimeout = Glib::signal_timeout().connect(
       sigc::mem_fun(this, &ToolTip::OnTimeout), 5000);
 }
 
@@ -182,7 +295,7 @@ ToolTip::on_show(void)
  *
  * view::ToolTip::OnTimeout --
  *
- *      Timeout callback. Deletes widget.
+ *      Timeout callback. Releases widget.
  *
  * Results:
  *      false to prevent timeout being re-queued.
@@ -196,7 +309,7 @@ ToolTip::on_show(void)
 bool
 ToolTip::OnTimeout(void)
 {
-   delete this;
+   Release();
    return false;
 }
 
@@ -221,6 +334,10 @@ ToolTip::OnTimeout(void)
 void
 ToolTip::UpdatePosition(void)
 {
+   if (!mTarget) {
+      return;
+   }
+
    Gtk::Requisition requisition;
    size_request(requisition);
    int w = requisition.width;
@@ -233,11 +350,14 @@ ToolTip::UpdatePosition(void)
     * intuitive. --plangdale
     */
 
-   // x,y are initialised to the widget's window's x,y.
+   /*
+    * x,y are initialised to the widget's window's x,y. The tracker keeps
+    * this up to date for us, so we don't need to ask the X server.
+    */
    int x, y;
-   mTarget.get_window()->get_origin(x, y);
+   mTracker.GetOrigin(x, y);
 
-   Gtk::Allocation allocation = mTarget.get_allocation();
+   Gtk::Allocation allocation = mTarget->get_allocation();
 
    // x,y are offset for non-window widgets to get the widget's x,y in root co-ordinates.
    x += allocation.get_x();
@@ -257,9 +377,8 @@ ToolTip::UpdatePosition(void)
     * Now, the ideal x co-ordinate has been established, but we must
     * verify if it is acceptable given screen constraints.
     */
-   Glib::RefPtr<Gdk::Screen> screen = mTarget.get_screen();
-   Gdk::Rectangle monitor;
-   screen->get_monitor_geometry(screen->get_monitor_at_point(x, y), monitor);
+   const Gdk::Rectangle &monitor =
+      ScreenGeometry::Get(mTarget->get_screen()).GetMonitorGeometryAtPoint(x, y);
 
    /*
     * If the right edge of the tooltip is off the right edge of
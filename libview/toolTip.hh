@@ -25,12 +25,17 @@
  * toolTip.hh --
  *
  *      A tooltip look-alike widget that can be shown on demand.
+ *
+ *      Tips hide themselves after a timeout or when clicked. Hidden tips
+ *      are kept, still realized, in a small pool that ToolTip::Show draws
+ *      from, so showing a tip normally doesn't create any X resources.
  */
 
 #ifndef LIBVIEW_TOOLTIP_HH
 #define LIBVIEW_TOOLTIP_HH
 
 
+#include <gtkmm/label.h>
 #include <gtkmm/window.h>
 
 #include <libview/motionTracker.hh>
@@ -45,17 +50,29 @@ class ToolTip
 public:
    ToolTip(Gtk::Widget &target, const Glib::ustring &markup);
 
+   static ToolTip *Show(Gtk::Widget &target, const Glib::ustring &markup);
+
+   guint64 GetPaintedPixels(void) const { return mPaintedPixels; }
+
 protected:
    bool on_button_press_event(GdkEventButton *event);
    bool on_expose_event(GdkEventExpose *event);
    void on_show(void);
 
 private:
+   void SetTip(Gtk::Widget &target, const Glib::ustring &markup);
+   void Release(void);
    bool OnTimeout(void);
    void UpdatePosition(void);
 
-   Gtk::Widget &mTarget;
+   Gtk::Widget *mTarget;
+   Gtk::Label *mLabel;
    MotionTracker mTracker;
+   sigc::connection mTimeout;
+   guint64 mPaintedPixels;
+
+   static std::vector<ToolTip *> sPool;
+   static const std::vector<ToolTip *>::size_type sMaxPooled = 4;
 };
 
 
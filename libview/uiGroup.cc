@@ -27,12 +27,95 @@
  *      This module implements the view::UIGroup class
  */
 
+#include <cstring>
+#include <set>
+#include <glibmm/markup.h>
+
 #include <libview/uiGroup.hh>
 
 
+#define UI_NODE_TYPES_KEY "libview-ui-node-types"
+
+
 namespace view {
 
 
+/*
+ * Records the element of every node of a UI definition, keyed by path.
+ */
+class UINodeTypeParser
+   : public Glib::Markup::Parser
+{
+public:
+   UINodeTypeParser(UIGroup::NodeTypeMap &types) : mTypes(types) { }
+
+protected:
+   void on_start_element(Glib::Markup::ParseContext &context,
+                         const Glib::ustring &element,
+                         const AttributeMap &attributes);
+   void on_end_element(Glib::Markup::ParseContext &context,
+                       const Glib::ustring &element);
+
+private:
+   UIGroup::NodeTypeMap &mTypes;
+   std::vector<std::string> mPaths;
+};
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UINodeTypeParser::on_start_element --
+ * view::UINodeTypeParser::on_end_element --
+ *
+ *      Markup parser callbacks. Nodes are named the way GtkUIManager names
+ *      them: by their name attribute, else their action, else their element.
+ *      Each node found takes a reference on its entry in the table.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+UINodeTypeParser::on_start_element(Glib::Markup::ParseContext &context, // IN
+                                   const Glib::ustring &element,        // IN
+                                   const AttributeMap &attributes)      // IN
+{
+   if (element == "ui") {
+      mPaths.push_back("");
+      return;
+   }
+
+   AttributeMap::const_iterator name = attributes.find("name");
+   AttributeMap::const_iterator action = attributes.find("action");
+   std::string nodeName = name != attributes.end() ? name->second
+                        : action != attributes.end() ? action->second
+                        : element;
+   std::string path = (mPaths.empty() ? "" : mPaths.back()) + "/" + nodeName;
+
+   UIGroup::NodeType &type = mTypes[path];
+   if (type.refs++ == 0) {
+      type.element = element;
+   }
+   mPaths.push_back(path);
+}
+
+
+void
+UINodeTypeParser::on_end_element(Glib::Markup::ParseContext &context, // IN
+                                 const Glib::ustring &element)        // IN
+{
+   if (!mPaths.empty()) {
+      mPaths.pop_back();
+   }
+}
+
+
 /*
  *-----------------------------------------------------------------------------
  *
@@ -50,8 +133,7 @@ namespace view {
  */
 
 UIGroup::UIGroup()
-   : mMergeID(0),
-     mMerged(false)
+   : mMerged(false)
 {
 
 }
@@ -85,7 +167,8 @@ UIGroup::~UIGroup()
  * view::UIGroup::AddUI --
  *
  *      Add a UI element to our vector. The parameters are the exact ones that
- *      will be passed to Gtk::UIManager::add_ui at merge time.
+ *      would be passed to Gtk::UIManager::add_ui at merge time. The strings
+ *      are interned, so groups sharing paths and actions share the copies.
  *
  * Results:
  *      None.
@@ -103,7 +186,10 @@ UIGroup::AddUI(const Glib::ustring &path,   // IN: Point in UI Def to insert ele
                UIManagerItemType type,      // IN: Type of element
                bool top)                    // IN: Is element inserted at top of parent
 {
-   mUIEntries.push_back((UIEntry){path, name, action, type, top, false});
+   mUIEntries.push_back((UIEntry){g_quark_from_string(path.c_str()),
+                                  g_quark_from_string(name.c_str()),
+                                  g_quark_from_string(action.c_str()),
+                                  type, top, false});
 }
 
 
@@ -113,7 +199,7 @@ UIGroup::AddUI(const Glib::ustring &path,   // IN: Point in UI Def to insert ele
  * view::UIGroup::AddUISeparator --
  *
  *      Add a separator element to our vector. The parameters are the exact ones that
- *      will be passed to Gtk::UIManager::add_ui_separator at merge time.
+ *      would be passed to Gtk::UIManager::add_ui_separator at merge time.
  *
  * Results:
  *      None.
@@ -130,7 +216,9 @@ UIGroup::AddUISeparator(const Glib::ustring &path, // IN: Point in UI Def to ins
                         UIManagerItemType type,    // IN: Type of separator
                         bool top)                  // IN: Is separator inserted at top
 {
-   mUIEntries.push_back((UIEntry){path, name, "", type, top, true});
+   mUIEntries.push_back((UIEntry){g_quark_from_string(path.c_str()),
+                                  g_quark_from_string(name.c_str()),
+                                  0, type, top, true});
 }
 
 
@@ -157,20 +245,60 @@ UIGroup::Clear(void)
 }
 
 
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UIGroup::UIEntry::operator== --
+ *
+ *      Compare two entries field by field. The strings are interned, so
+ *      this is just integer comparisons.
+ *
+ * Results:
+ *      true if the entries would produce the same add_ui call.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+bool
+UIGroup::UIEntry::operator==(const UIEntry &other) // IN
+   const
+{
+   return isSeparator == other.isSeparator && type == other.type &&
+          top == other.top && path == other.path && name == other.name &&
+          action == other.action;
+}
+
+
 /*
  *-----------------------------------------------------------------------------
  *
  * view::UIGroup::Merge --
  *
- *      Conditionally merge the new UI entries into the UIManager. If this group
- *      was previously merged, unmerge first. If there are no UI entries, do not
- *      bother creating a merge id.
+ *      Conditionally merge the new UI entries into the UIManager. If there are
+ *      no UI entries, do nothing.
+ *
+ *      Entries are merged in chunks: runs of consecutive entries with the
+ *      same path, each under its own merge id. If this group was merged
+ *      before, only the chunks a change touches are removed and added
+ *      again. Placement among siblings depends on the order entries are
+ *      added in, so the order of entries with the same parent has to be
+ *      kept: once an entry is re-added, every later entry with the same
+ *      path is re-added after it. Chunks of other paths after the change
+ *      stay merged, unless they were added entry by entry (add_ui does
+ *      not reference the ancestors, so those may vanish with them).
+ *
+ *      Each chunk is compiled into a UI definition and added with one
+ *      add_ui_from_string call. If it can't be compiled (see Compile), its
+ *      entries are added one by one instead.
  *
  * Results:
  *      None.
  *
  * Side effects:
- *      None.
+ *      The UIManager queues an update unless nothing changed.
  *
  *-----------------------------------------------------------------------------
  */
@@ -179,22 +307,134 @@ void
 UIGroup::Merge(Glib::RefPtr<Gtk::UIManager> uiManager) // IN: UIManager
    const
 {
-   if (mUIEntries.size()) {
-      Unmerge(uiManager);
+   if (mUIEntries.empty()) {
+      return;
+   }
 
-      mMergeID = uiManager->new_merge_id();
+   size_type oldSize = mMergedEntries.size();
+   size_type newSize = mUIEntries.size();
 
-      for (const_iterator i = mUIEntries.begin(); i != mUIEntries.end(); i++) {
-         if ((*i).isSeparator) {
-            uiManager->add_ui_separator(mMergeID, (*i).path, (*i).name, (*i).type, 
-                                        (*i).top);
-         } else {
-            uiManager->add_ui(mMergeID, (*i).path, (*i).name, (*i).action, (*i).type, 
-                              (*i).top);
-         }
-      }
+   size_type prefix = 0;
+   while (prefix < oldSize && prefix < newSize &&
+          mMergedEntries[prefix] == mUIEntries[prefix]) {
+      prefix++;
+   }
+   if (prefix == oldSize && prefix == newSize) {
       mMerged = true;
+      return;
+   }
+
+   size_type suffix = 0;
+   while (suffix < oldSize - prefix && suffix < newSize - prefix &&
+          mMergedEntries[oldSize - 1 - suffix] == mUIEntries[newSize - 1 - suffix]) {
+      suffix++;
+   }
+
+   // Paths whose children change order or membership.
+   std::set<GQuark> changed;
+   for (size_type i = prefix; i < oldSize - suffix; i++) {
+      changed.insert(mMergedEntries[i].path);
+   }
+   for (size_type i = prefix; i < newSize - suffix; i++) {
+      changed.insert(mUIEntries[i].path);
+   }
+
+   std::vector<MergeChunk> chunks;
+   std::vector<MergeChunk> kept;
+   for (std::vector<MergeChunk>::size_type i = 0; i < mMergeChunks.size(); i++) {
+      MergeChunk &chunk = mMergeChunks[i];
+
+      if (chunk.end <= prefix) {
+         chunks.push_back(chunk);
+      } else if (chunk.start >= oldSize - suffix && chunk.compiled &&
+                 changed.find(mMergedEntries[chunk.start].path) == changed.end()) {
+         chunk.start = chunk.start - oldSize + newSize;
+         chunk.end = chunk.end - oldSize + newSize;
+         kept.push_back(chunk);
+      } else {
+         RemoveChunk(uiManager, chunk);
+      }
+   }
+
+   size_type next = chunks.empty() ? 0 : chunks.back().end;
+   std::vector<MergeChunk>::size_type k = 0;
+   while (next < newSize) {
+      if (k < kept.size() && kept[k].start == next) {
+         chunks.push_back(kept[k]);
+         next = kept[k].end;
+         k++;
+         continue;
+      }
+
+      size_type end = next + 1;
+      while (end < newSize && mUIEntries[end].path == mUIEntries[next].path &&
+             !(k < kept.size() && kept[k].start == end)) {
+         end++;
+      }
+      chunks.push_back(AddChunk(uiManager, next, end));
+      next = end;
    }
+
+   mMergeChunks.swap(chunks);
+   mMergedEntries = mUIEntries;
+   mMerged = true;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UIGroup::AddChunk --
+ *
+ *      Add the entries [from, to) to the UIManager under a new merge id,
+ *      compiled into one definition if possible, and take references on
+ *      the nodes they add.
+ *
+ * Results:
+ *      The new chunk.
+ *
+ * Side effects:
+ *      The UIManager queues an update.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+UIGroup::MergeChunk
+UIGroup::AddChunk(Glib::RefPtr<Gtk::UIManager> uiManager, // IN: UIManager
+                  size_type from,                         // IN: First entry
+                  size_type to)                           // IN: End of entries
+   const
+{
+   Glib::ustring ui;
+   NodeVector nodes;
+   MergeChunk chunk;
+   chunk.start = from;
+   chunk.end = to;
+   chunk.compiled = false;
+
+   if (Compile(uiManager, from, to, ui, nodes)) {
+      try {
+         chunk.id = uiManager->add_ui_from_string(ui);
+         chunk.compiled = true;
+      } catch (const Glib::Error &e) {
+         // Fall through to adding the entries one by one.
+      }
+   }
+   if (!chunk.compiled) {
+      chunk.id = uiManager->new_merge_id();
+      AddEntries(uiManager, chunk.id, from, to);
+   }
+
+   NodeTypeMap &types = GetNodeTypes(uiManager);
+   for (NodeVector::size_type i = 0; i < nodes.size(); i++) {
+      NodeType &type = types[nodes[i].first];
+      if (type.refs++ == 0) {
+         type.element = nodes[i].second;
+      }
+      chunk.nodes.push_back(nodes[i].first);
+   }
+
+   return chunk;
 }
 
 
@@ -219,12 +459,363 @@ UIGroup::Unmerge(Glib::RefPtr<Gtk::UIManager> uiManager) // IN: UIManager
    const
 {
    if (IsMerged()) {
-      uiManager->remove_ui(mMergeID);
+      for (std::vector<MergeChunk>::size_type i = 0; i < mMergeChunks.size(); i++) {
+         RemoveChunk(uiManager, mMergeChunks[i]);
+      }
+      mMergeChunks.clear();
+      mMergedEntries.clear();
       mMerged = false;
    }
 }
 
 
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UIGroup::RemoveChunk --
+ *
+ *      Remove a merged chunk from the UIManager, and drop the references
+ *      its entries hold on the UIManager's node types.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      The UIManager queues an update.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+UIGroup::RemoveChunk(Glib::RefPtr<Gtk::UIManager> uiManager, // IN: UIManager
+                     const MergeChunk &chunk)                // IN: Chunk
+   const
+{
+   uiManager->remove_ui(chunk.id);
+
+   NodeTypeMap &types = GetNodeTypes(uiManager);
+   for (std::vector<std::string>::size_type i = 0; i < chunk.nodes.size(); i++) {
+      NodeTypeMap::iterator type = types.find(chunk.nodes[i]);
+      if (type != types.end() && --type->second.refs == 0) {
+         types.erase(type);
+      }
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UIGroup::AddEntries --
+ *
+ *      Add the entries [from, to) with individual add_ui and
+ *      add_ui_separator calls.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+UIGroup::AddEntries(Glib::RefPtr<Gtk::UIManager> uiManager, // IN: UIManager
+                    ui_merge_id mergeID,                    // IN: Merge id to use
+                    size_type from,                         // IN: First entry
+                    size_type to)                           // IN: End of entries
+   const
+{
+   for (const_iterator i = mUIEntries.begin() + from; i != mUIEntries.begin() + to;
+        i++) {
+      if ((*i).isSeparator) {
+         uiManager->add_ui_separator(mergeID, g_quark_to_string((*i).path),
+                                     g_quark_to_string((*i).name), (*i).type,
+                                     (*i).top);
+      } else {
+         uiManager->add_ui(mergeID, g_quark_to_string((*i).path),
+                           g_quark_to_string((*i).name),
+                           g_quark_to_string((*i).action), (*i).type, (*i).top);
+      }
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UIGroup::Compile --
+ *
+ *      Build a UI definition equivalent to adding the entries [from, to)
+ *      with add_ui.
+ *
+ *      A definition has to spell out every ancestor of an entry with the
+ *      right element. Those are looked up among the entries compiled
+ *      before and in the node types of the UIManager (see GetNodeTypes),
+ *      which only know what UIGroups and AddUIFromString put there:
+ *      asking the UIManager itself would rebuild its UI synchronously.
+ *      Ancestors are written without their
+ *      action, so the definition never changes the action of a node it
+ *      doesn't add. UI_MANAGER_AUTO is resolved against the parent the
+ *      same way add_ui does.
+ *
+ * Results:
+ *      true and the definition in ui, or false if an ancestor is unknown,
+ *      an entry has no valid element under its parent or an entry with
+ *      UI_MANAGER_AUTO is at the root. Either way, nodes gets the path and
+ *      element of each named node the entries add, where it is known.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+bool
+UIGroup::Compile(Glib::RefPtr<Gtk::UIManager> uiManager, // IN: UIManager
+                 size_type from,                         // IN: First entry
+                 size_type to,                           // IN: End of entries
+                 Glib::ustring &ui,                      // OUT: UI definition
+                 NodeVector &nodes)                      // OUT: Nodes added
+   const
+{
+   const NodeTypeMap &types = GetNodeTypes(uiManager);
+   std::map<std::string, std::string> added;
+   bool compiled = true;
+   std::string xml = "<ui>";
+
+   for (const_iterator i = mUIEntries.begin() + from; i != mUIEntries.begin() + to;
+        i++) {
+      std::vector<std::string> names;
+      std::vector<std::string> elements;
+      std::string path;
+      bool known = true;
+
+      gchar **components = g_strsplit(g_quark_to_string((*i).path), "/", -1);
+      for (gchar **component = components; *component; component++) {
+         if (!**component) {
+            continue;
+         }
+         path += "/";
+         path += *component;
+
+         std::map<std::string, std::string>::const_iterator own =
+            added.find(path);
+         NodeTypeMap::const_iterator type = types.find(path);
+         if (own != added.end()) {
+            elements.push_back(own->second);
+         } else if (type != types.end()) {
+            elements.push_back(type->second.element);
+         } else {
+            known = false;
+            break;
+         }
+         names.push_back(*component);
+      }
+      g_strfreev(components);
+
+      const char *element = known ? GetElement(*i, elements) : NULL;
+      if (!element) {
+         compiled = false;
+         continue;
+      }
+
+      for (std::vector<std::string>::size_type k = 0; k < names.size(); k++) {
+         xml += "<" + elements[k] + " name=\"" +
+                Glib::Markup::escape_text(names[k]).raw() + "\">";
+      }
+
+      const char *name = g_quark_to_string((*i).name);
+      const char *action = (*i).isSeparator ? "" : g_quark_to_string((*i).action);
+      xml += "<";
+      xml += element;
+      if (*name) {
+         xml += " name=\"" + Glib::Markup::escape_text(name).raw() + "\"";
+      }
+      if (*action) {
+         xml += " action=\"" + Glib::Markup::escape_text(action).raw() + "\"";
+      }
+      if (!names.empty() && strcmp(element, "accelerator") != 0) {
+         xml += (*i).top ? " position=\"top\"" : " position=\"bot\"";
+      }
+      xml += "/>";
+
+      for (std::vector<std::string>::size_type k = names.size(); k-- > 0;) {
+         xml += "</" + elements[k] + ">";
+      }
+
+      const char *nodeName = *name ? name : action;
+      if (*nodeName) {
+         nodes.push_back(std::make_pair(path + "/" + nodeName,
+                                        std::string(element)));
+         added[nodes.back().first] = element;
+      }
+   }
+
+   xml += "</ui>";
+   ui = xml;
+   return compiled;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UIGroup::GetElement --
+ *
+ *      Get the element an entry is added as, given the elements of its
+ *      ancestors, outermost first.
+ *
+ * Results:
+ *      The element, or NULL if the entry has no valid element there or is
+ *      a top level UI_MANAGER_AUTO entry.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+const char *
+UIGroup::GetElement(const UIEntry &entry,                        // IN
+                    const std::vector<std::string> &ancestors)   // IN
+{
+   std::string container;
+   for (std::vector<std::string>::size_type k = ancestors.size(); k-- > 0;) {
+      if (ancestors[k] != "placeholder") {
+         container = ancestors[k];
+         break;
+      }
+   }
+
+   bool inMenu = container == "menubar" || container == "menu" ||
+                 container == "popup";
+   bool inToolbar = container == "toolbar";
+   switch (entry.type) {
+   case Gtk::UI_MANAGER_AUTO:
+      /*
+       * A top level entry is left to AddEntries, so add_ui resolves it
+       * exactly as it would without compiling.
+       */
+      if (inMenu || inToolbar) {
+         return entry.isSeparator ? "separator"
+              : inMenu ? "menuitem" : "toolitem";
+      }
+      return NULL;
+   case Gtk::UI_MANAGER_MENUBAR:     return "menubar";
+   case Gtk::UI_MANAGER_MENU:        return "menu";
+   case Gtk::UI_MANAGER_TOOLBAR:     return "toolbar";
+   case Gtk::UI_MANAGER_PLACEHOLDER: return "placeholder";
+   case Gtk::UI_MANAGER_POPUP:       return "popup";
+   case Gtk::UI_MANAGER_MENUITEM:    return "menuitem";
+   case Gtk::UI_MANAGER_TOOLITEM:    return "toolitem";
+   case Gtk::UI_MANAGER_SEPARATOR:   return "separator";
+   case Gtk::UI_MANAGER_ACCELERATOR: return "accelerator";
+   default:                          return NULL;
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UIGroup::GetNodeTypes --
+ *
+ *      Get the table of node elements kept on a UIManager, by path. It
+ *      holds the nodes added by merged UIGroups and by AddUIFromString,
+ *      each with a count of the definitions that add it.
+ *
+ * Results:
+ *      The table.
+ *
+ * Side effects:
+ *      The table is created on first use, and lives as long as the
+ *      UIManager.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+UIGroup::NodeTypeMap &
+UIGroup::GetNodeTypes(Glib::RefPtr<Gtk::UIManager> uiManager) // IN: UIManager
+{
+   GObject *object = G_OBJECT(uiManager->gobj());
+   NodeTypeMap *types =
+      static_cast<NodeTypeMap *>(g_object_get_data(object, UI_NODE_TYPES_KEY));
+
+   if (!types) {
+      types = new NodeTypeMap();
+      g_object_set_data_full(object, UI_NODE_TYPES_KEY, types,
+                             &UIGroup::DestroyNodeTypes);
+   }
+   return *types;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UIGroup::AddUIFromString --
+ *
+ *      Counterpart of Gtk::UIManager::add_ui_from_string that also makes
+ *      the nodes of ui known to UIGroups, so that groups merged under them
+ *      can be compiled. UI definitions added directly to the UIManager
+ *      still work, but groups under their nodes are added entry by entry.
+ *
+ *      The nodes stay known until the UIManager is destroyed, even if the
+ *      definition is removed.
+ *
+ * Results:
+ *      The merge id of the definition.
+ *
+ * Side effects:
+ *      Throws Glib::Error if ui can't be parsed.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+Gtk::UIManager::ui_merge_id
+UIGroup::AddUIFromString(Glib::RefPtr<Gtk::UIManager> uiManager, // IN: UIManager
+                         const Glib::ustring &ui)                // IN: Definition
+{
+   ui_merge_id id = uiManager->add_ui_from_string(ui);
+
+   UINodeTypeParser parser(GetNodeTypes(uiManager));
+   Glib::Markup::ParseContext context(parser);
+   try {
+      context.parse(ui);
+      context.end_parse();
+   } catch (const Glib::MarkupError &e) {
+      // The UIManager accepted it, so this can't happen.
+   }
+
+   return id;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UIGroup::DestroyNodeTypes --
+ *
+ *      GDestroyNotify for the table kept by GetNodeTypes.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+UIGroup::DestroyNodeTypes(gpointer data) // IN
+{
+   delete static_cast<NodeTypeMap *>(data);
+}
+
+
 /*
  *-----------------------------------------------------------------------------
  *
@@ -274,4 +865,135 @@ UIGroup::EmitChanged(void)
 }
 
 
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UITransaction::UITransaction --
+ *
+ *      Constructor. Start a batch of merges and unmerges against uiManager.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+UITransaction::UITransaction(Glib::RefPtr<Gtk::UIManager> uiManager) // IN
+   : mUIManager(uiManager)
+{
+
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UITransaction::~UITransaction --
+ *
+ *      Destructor. Commits anything not committed yet.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      See Commit.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+UITransaction::~UITransaction()
+{
+   Commit();
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UITransaction::Merge --
+ * view::UITransaction::Unmerge --
+ *
+ *      Record that group should end up merged or unmerged. Nothing touches
+ *      the UIManager until Commit. If a group is recorded more than once,
+ *      the last call wins.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+UITransaction::Merge(const UIGroup *group) // IN
+{
+   if (mMerge.find(group) == mMerge.end()) {
+      mGroups.push_back(group);
+   }
+   mMerge[group] = true;
+}
+
+
+void
+UITransaction::Unmerge(const UIGroup *group) // IN
+{
+   if (mMerge.find(group) == mMerge.end()) {
+      mGroups.push_back(group);
+   }
+   mMerge[group] = false;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::UITransaction::Commit --
+ *
+ *      Apply the recorded changes: unmerge first, then merge in the order
+ *      the groups were first recorded, so merged groups are positioned
+ *      relative to the final set of other groups. Each group only re-merges
+ *      the chunks its changes touch (see UIGroup::Merge).
+ *      The UIManager is then brought up to date once.
+ *
+ *      The transaction can be reused afterwards.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      Menus and toolbars are rebuilt synchronously if anything changed.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+UITransaction::Commit(void)
+{
+   if (mGroups.empty()) {
+      return;
+   }
+
+   for (std::vector<const UIGroup *>::size_type i = 0; i < mGroups.size(); i++) {
+      if (!mMerge[mGroups[i]]) {
+         mGroups[i]->Unmerge(mUIManager);
+      }
+   }
+   for (std::vector<const UIGroup *>::size_type i = 0; i < mGroups.size(); i++) {
+      if (mMerge[mGroups[i]]) {
+         mGroups[i]->Merge(mUIManager);
+      }
+   }
+
+   mGroups.clear();
+   mMerge.clear();
+
+   mUIManager->ensure_update();
+}
+
+
 } // namespace view
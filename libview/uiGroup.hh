@@ -36,6 +36,17 @@
  *      this UIGroup object in some way. The consumer than merges the UI Def
  *      into the UI Manager.
  *
+ *      Merging a group that is already merged only touches the chunks of
+ *      entries that changed, and a UITransaction batches merges and
+ *      unmerges of several groups into one UI rebuild.
+ *
+ *      Paths, names and actions are interned as GQuarks. When merging, the
+ *      entries are compiled into UI definitions, one add_ui_from_string
+ *      call per run of entries with the same path. That needs the elements
+ *      of the nodes the entries go under, which UIGroups track themselves,
+ *      per UIManager: nodes added by merged groups, or by AddUIFromString,
+ *      are known.
+ *
  */
 
 #ifndef LIBVIEW_UIGROUP_HH
@@ -43,6 +54,8 @@
 
 
 #include <gtkmm/uimanager.h>
+#include <map>
+#include <string>
 #include <vector>
 
 
@@ -65,6 +78,9 @@ public:
                        UIManagerItemType type = Gtk::UI_MANAGER_AUTO, bool top = true);
    void Clear(void);
 
+   static Gtk::UIManager::ui_merge_id AddUIFromString(
+      Glib::RefPtr<Gtk::UIManager> uiManager, const Glib::ustring &ui);
+
    void Merge(Glib::RefPtr<Gtk::UIManager> uiManager) const;
    void Unmerge(Glib::RefPtr<Gtk::UIManager> uiManager) const;
 
@@ -77,28 +93,87 @@ public:
    sigc::signal<void, const UIGroup *> changedSignal;
 
 private:
+   friend class UINodeTypeParser;
 
    struct UIEntry {
-      Glib::ustring path;
-      Glib::ustring name;
-      Glib::ustring action;
+      GQuark path;
+      GQuark name;
+      GQuark action;
       UIManagerItemType type;
       bool top;
 
       bool isSeparator;
+
+      bool operator==(const UIEntry &other) const;
    };
 
    typedef std::vector<UIEntry>::const_iterator const_iterator;
+   typedef std::vector<UIEntry>::size_type size_type;
    typedef Gtk::UIManager::ui_merge_id ui_merge_id;
 
+   // Element of a node in a UIManager, and how many definitions add it.
+   struct NodeType {
+      NodeType() : refs(0) { }
+
+      std::string element;
+      unsigned int refs;
+   };
+   typedef std::map<std::string, NodeType> NodeTypeMap;
+   typedef std::vector<std::pair<std::string, std::string> > NodeVector;
+
+   // Entries [start, end), all with the same path, merged under id.
+   struct MergeChunk {
+      size_type start;
+      size_type end;
+      ui_merge_id id;
+      bool compiled;
+      std::vector<std::string> nodes;
+   };
+
+   MergeChunk AddChunk(Glib::RefPtr<Gtk::UIManager> uiManager, size_type from,
+                       size_type to) const;
+   bool Compile(Glib::RefPtr<Gtk::UIManager> uiManager, size_type from,
+                size_type to, Glib::ustring &ui, NodeVector &nodes) const;
+   void AddEntries(Glib::RefPtr<Gtk::UIManager> uiManager, ui_merge_id mergeID,
+                   size_type from, size_type to) const;
+   void RemoveChunk(Glib::RefPtr<Gtk::UIManager> uiManager,
+                    const MergeChunk &chunk) const;
+
+   static const char *GetElement(const UIEntry &entry,
+                                 const std::vector<std::string> &ancestors);
+   static NodeTypeMap &GetNodeTypes(Glib::RefPtr<Gtk::UIManager> uiManager);
+   static void DestroyNodeTypes(gpointer data);
+
    std::vector<UIEntry> mUIEntries;
-   mutable ui_merge_id mMergeID;
+
+   // What is currently in the UIManager.
+   mutable std::vector<UIEntry> mMergedEntries;
+   mutable std::vector<MergeChunk> mMergeChunks;
 
    // There are no invalid values of ui_merge_id so we need a separate flag
    mutable bool mMerged;
 };
 
 
+class UITransaction
+{
+public:
+   UITransaction(Glib::RefPtr<Gtk::UIManager> uiManager);
+   ~UITransaction();
+
+   void Merge(const UIGroup *group);
+   void Unmerge(const UIGroup *group);
+   void Commit(void);
+
+private:
+   Glib::RefPtr<Gtk::UIManager> mUIManager;
+
+   // Groups in the order they were first seen, and whether to merge each.
+   std::vector<const UIGroup *> mGroups;
+   std::map<const UIGroup *, bool> mMerge;
+};
+
+
 } // namespace view
 
 
@@ -33,17 +33,22 @@
 
 
 #include <libview/actionGroup.hh>
+#include <libview/actionGroupRegistry.hh>
 #include <libview/baseBGBox.hh>
 #include <libview/contentBox.hh>
 #include <libview/header.hh>
+#include <libview/mainThreadDispatcher.hh>
 #include <libview/menuToggleAction.hh>
 #include <libview/motionTracker.hh>
+#include <libview/parkingLot.hh>
 #include <libview/reparenter.hh>
+#include <libview/screenGeometry.hh>
 #include <libview/spinnerAction.hh>
 #include <libview/spinner.hh>
 #include <libview/toolTip.hh>
 #include <libview/uiGroup.hh>
 #include <libview/viewport.hh>
+#include <libview/virtualList.hh>
 #include <libview/weakPtr.hh>
 #include <libview/widthHeight.hh>
 #include <libview/wrapLabel.hh>
@@ -0,0 +1,733 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * virtualList.cc --
+ *
+ *      A scrolling list that only has widgets for the rows in view.
+ */
+
+
+#include <algorithm>
+
+#include <libview/virtualList.hh>
+
+
+namespace view {
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TreeAdd --
+ *
+ *      Add delta to one element of a Fenwick tree.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+TreeAdd(std::vector<long> &tree, // IN/OUT
+        size_t index,            // IN
+        long delta)              // IN
+{
+   for (size_t i = index + 1; i <= tree.size(); i += i & -i) {
+      tree[i - 1] += delta;
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TreeSum --
+ *
+ *      Sum the elements of a Fenwick tree before end.
+ *
+ * Results:
+ *      The sum of elements [0, end).
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static long
+TreeSum(const std::vector<long> &tree, // IN
+        size_t end)                    // IN
+{
+   long sum = 0;
+   for (size_t i = end; i > 0; i -= i & -i) {
+      sum += tree[i - 1];
+   }
+   return sum;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::VirtualList --
+ *
+ *      Constructor. The model must outlive the list.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+VirtualList::VirtualList(Gtk::Adjustment &hadjustment, // IN
+                         Gtk::Adjustment &vadjustment, // IN
+                         Model &model,                 // IN
+                         const RowFactory &factory,    // IN
+                         const RowBinder &binder)      // IN
+   : Viewport(hadjustment, vadjustment),
+     mModel(model),
+     mFactory(factory),
+     mBinder(binder),
+     mFixed(Gtk::manage(new Gtk::Fixed())),
+     mOverscan(2),
+     mEstimatedRowHeight(24),
+     mRowWidth(1),
+     mContentHeight(-1),
+     mInLayout(false)
+{
+   mFixed->show();
+   add(*mFixed);
+
+   mModel.rowsChanged.connect(sigc::mem_fun(this, &VirtualList::OnRowsChanged));
+   mModel.rowChanged.connect(sigc::mem_fun(this, &VirtualList::OnRowChanged));
+
+   signal_set_scroll_adjustments().connect(
+      sigc::mem_fun(this, &VirtualList::OnAdjustmentsSet), true);
+   OnAdjustmentsSet(&hadjustment, &vadjustment);
+
+   OnRowsChanged();
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::SetOverscan --
+ *
+ *      Set how many rows beyond each edge of the view have widgets, so
+ *      that scrolling by a little doesn't have to bind rows first.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Rows may be shown or hidden.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::SetOverscan(unsigned int rows) // IN
+{
+   mOverscan = rows;
+   Layout();
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::SetEstimatedRowHeight --
+ *
+ *      Set the height assumed for rows that haven't been measured, until
+ *      some rows have been.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The list may change size.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::SetEstimatedRowHeight(int height) // IN
+{
+   g_return_if_fail(height > 0);
+
+   mEstimatedRowHeight = height;
+   Layout();
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::GetEstimatedRowHeight --
+ *
+ *      Get the height assumed for rows that haven't been measured: the
+ *      average height of the measured rows, or the height given to
+ *      SetEstimatedRowHeight if there are none.
+ *
+ * Results:
+ *      The estimated row height.
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+int
+VirtualList::GetEstimatedRowHeight(void)
+   const
+{
+   long measured = TreeSum(mMeasuredTree, mHeights.size());
+   if (measured == 0) {
+      return mEstimatedRowHeight;
+   }
+
+   long total = TreeSum(mHeightTree, mHeights.size());
+   return std::max((int)((total + measured / 2) / measured), 1);
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::ScrollToRow --
+ *
+ *      Scroll so that a row is at the top of the view, or as near as the
+ *      end of the list allows.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Rows are bound and shown.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::ScrollToRow(size_t row) // IN
+{
+   Gtk::Adjustment *vadjustment = get_vadjustment();
+   g_return_if_fail(vadjustment);
+   g_return_if_fail(row < mHeights.size());
+
+   double value = std::min((double)GetRowY(row),
+                           vadjustment->get_upper() - vadjustment->get_page_size());
+   vadjustment->set_value(std::max(value, vadjustment->get_lower()));
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::GetRowWidget --
+ *
+ *      Get the widget showing a row.
+ *
+ * Results:
+ *      The row's widget, or NULL if the row has none right now.
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+Gtk::Widget *
+VirtualList::GetRowWidget(size_t row) // IN
+   const
+{
+   RowMap::const_iterator i = mRows.find(row);
+   return i == mRows.end() ? NULL : i->second.widget;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::on_size_allocate --
+ *
+ *      Size allocation handler. Rows are as wide as the view, and the
+ *      view's height decides how many rows are shown.
+ *
+ *      The Gtk::Fixed gives each row the width it requests, so the rows are
+ *      allocated again at the width of the view. Their size requests are
+ *      left alone, so that they never hold the list open horizontally.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Rows may be resized, shown or hidden.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::on_size_allocate(Gtk::Allocation &allocation) // IN
+{
+   Viewport::on_size_allocate(allocation);
+
+   mRowWidth = std::max(mFixed->get_allocation().get_width(), 1);
+   Layout();
+
+   for (RowMap::iterator i = mRows.begin(); i != mRows.end(); i++) {
+      Gtk::Widget *widget = i->second.widget;
+      Gtk::Allocation rowAllocation = widget->get_allocation();
+      if (widget->is_visible() && rowAllocation.get_width() != mRowWidth) {
+         rowAllocation.set_width(mRowWidth);
+         widget->size_allocate(rowAllocation);
+      }
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::OnRowsChanged --
+ *
+ *      Handler for the model's rowsChanged signal. Starts over with every
+ *      row unmeasured, estimating their height from the rows measured so
+ *      far.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Every shown row is bound again.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::OnRowsChanged(void)
+{
+   mEstimatedRowHeight = GetEstimatedRowHeight();
+
+   while (!mRows.empty()) {
+      ReleaseRow(mRows.begin());
+   }
+
+   size_t count = mModel.GetRowCount();
+   mHeights.assign(count, 0);
+   mHeightTree.assign(count, 0);
+   mMeasuredTree.assign(count, 0);
+
+   Layout();
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::OnRowChanged --
+ *
+ *      Handler for the model's rowChanged signal. Rows without a widget
+ *      are bound when they are next shown anyway, and keep their last
+ *      measured height until then.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The row may be bound again.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::OnRowChanged(size_t row) // IN
+{
+   RowMap::iterator i = mRows.find(row);
+   if (i == mRows.end()) {
+      return;
+   }
+
+   mBinder(*i->second.widget, row);
+   Layout();
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::OnScrolled --
+ *
+ *      Handler for the vertical adjustment's value changing.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Rows may be shown or hidden.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::OnScrolled(void)
+{
+   Layout();
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::OnAdjustmentsSet --
+ *
+ *      Handler for "set_scroll_adjustments", e.g. from a ScrolledWindow.
+ *      Follows the new vertical adjustment.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::OnAdjustmentsSet(Gtk::Adjustment *hadjustment, // IN: Unused
+                              Gtk::Adjustment *vadjustment) // IN: Unused
+{
+   mScrolledConnection.disconnect();
+
+   Gtk::Adjustment *adjustment = get_vadjustment();
+   if (adjustment) {
+      mScrolledConnection = adjustment->signal_value_changed().connect(
+         sigc::mem_fun(this, &VirtualList::OnScrolled));
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::Layout --
+ *
+ *      Give widgets to the rows in view plus the overscan, take them away
+ *      from the rest, and put the rows in place.
+ *
+ *      Rows are measured as they are shown. When that changes the height
+ *      of rows above the view, the scroll position is moved by as much, so
+ *      that the row at the top of the view stays where it is on screen.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      Rows may be bound, shown or hidden. The list may change size.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::Layout(void)
+{
+   Gtk::Adjustment *vadjustment = get_vadjustment();
+   if (mInLayout || !vadjustment) {
+      return;
+   }
+   mInLayout = true;
+
+   size_t count = mHeights.size();
+   int viewTop = (int)vadjustment->get_value();
+   int viewHeight = std::max((int)vadjustment->get_page_size(), 1);
+
+   size_t anchor = 0;
+   int anchorOffset = 0;
+
+   if (count > 0) {
+      anchor = FindRow(viewTop);
+      anchorOffset = viewTop - GetRowY(anchor);
+      size_t first = anchor > mOverscan ? anchor - mOverscan : 0;
+
+      /*
+       * Take the widgets away from rows clearly out of the new range
+       * first, so that they can be reused for the rows coming into view.
+       */
+      size_t guess = anchor + viewHeight / GetEstimatedRowHeight() + 1 + mOverscan;
+      RowMap::iterator i = mRows.begin();
+      while (i != mRows.end()) {
+         if (i->first < first || i->first > guess) {
+            ReleaseRow(i++);
+         } else {
+            i++;
+         }
+      }
+
+      /*
+       * Measuring rows moves the rows below them, so where the view ends
+       * is worked out again for every row.
+       */
+      size_t last;
+      unsigned int below = 0;
+      for (last = first; last < count; last++) {
+         if (GetRowY(last) >= GetRowY(anchor) + anchorOffset + viewHeight) {
+            if (below == mOverscan) {
+               break;
+            }
+            below++;
+         }
+
+         i = mRows.find(last);
+         if (i == mRows.end()) {
+            Row row;
+            row.widget = AcquireWidget();
+            row.y = -1;
+            mBinder(*row.widget, last);
+            i = mRows.insert(std::make_pair(last, row)).first;
+         }
+         MeasureRow(last, *i->second.widget);
+      }
+
+      i = mRows.lower_bound(last);
+      while (i != mRows.end()) {
+         ReleaseRow(i++);
+      }
+   }
+
+   int contentHeight = GetRowY(count);
+   if (contentHeight != mContentHeight) {
+      mContentHeight = contentHeight;
+      mFixed->set_size_request(1, std::max(contentHeight, 1));
+   }
+
+   for (RowMap::iterator i = mRows.begin(); i != mRows.end(); i++) {
+      int y = GetRowY(i->first);
+      if (y != i->second.y) {
+         i->second.y = y;
+         mFixed->move(*i->second.widget, 0, y);
+      }
+      i->second.widget->show();
+   }
+
+   if (count > 0) {
+      int value = GetRowY(anchor) + anchorOffset;
+      if (value != viewTop) {
+         vadjustment->set_value(value);
+      }
+   }
+
+   mInLayout = false;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::AcquireWidget --
+ *
+ *      Get a row widget, reusing a spare one if there is any.
+ *
+ * Results:
+ *      A hidden row widget in the list.
+ *
+ * Side effects:
+ *      May call the row factory.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+Gtk::Widget *
+VirtualList::AcquireWidget(void)
+{
+   Gtk::Widget *widget;
+
+   if (mSpareWidgets.empty()) {
+      widget = Gtk::manage(mFactory());
+      mFixed->put(*widget, 0, 0);
+   } else {
+      widget = mSpareWidgets.back();
+      mSpareWidgets.pop_back();
+   }
+   return widget;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::ReleaseRow --
+ *
+ *      Take a row's widget away and keep it for reuse. The widget stays
+ *      in the list, hidden, so that reusing it doesn't realize it again.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      The row is removed from mRows.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::ReleaseRow(RowMap::iterator row) // IN
+{
+   row->second.widget->hide();
+   mSpareWidgets.push_back(row->second.widget);
+   mRows.erase(row);
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::MeasureRow --
+ *
+ *      Record the height of a row from the size request of its widget.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::MeasureRow(size_t row,          // IN
+                        Gtk::Widget &widget) // IN
+{
+   Gtk::Requisition requisition;
+   widget.size_request(requisition);
+   int height = std::max(requisition.height, 1);
+
+   if (height != mHeights[row]) {
+      ForgetRowHeight(row);
+      mHeights[row] = height;
+      TreeAdd(mHeightTree, row, height);
+      TreeAdd(mMeasuredTree, row, 1);
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::ForgetRowHeight --
+ *
+ *      Go back to estimating the height of a row.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+VirtualList::ForgetRowHeight(size_t row) // IN
+{
+   if (mHeights[row]) {
+      TreeAdd(mHeightTree, row, -mHeights[row]);
+      TreeAdd(mMeasuredTree, row, -1);
+      mHeights[row] = 0;
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::GetRowY --
+ *
+ *      Get the position of the top of a row: the sum of the heights of
+ *      the rows above it, measured or estimated.
+ *
+ * Results:
+ *      The row's y coordinate. GetRowY(count) is the height of the list.
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+int
+VirtualList::GetRowY(size_t row) // IN
+   const
+{
+   long measured = TreeSum(mMeasuredTree, row);
+   return TreeSum(mHeightTree, row) +
+          ((long)row - measured) * GetEstimatedRowHeight();
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::VirtualList::FindRow --
+ *
+ *      Find the row at a y coordinate. The list must have rows.
+ *
+ * Results:
+ *      The last row starting at or above y.
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+size_t
+VirtualList::FindRow(int y) // IN
+   const
+{
+   size_t low = 0;
+   size_t high = mHeights.size();
+
+   while (high - low > 1) {
+      size_t mid = low + (high - low) / 2;
+      if (GetRowY(mid) <= y) {
+         low = mid;
+      } else {
+         high = mid;
+      }
+   }
+   return low;
+}
+
+
+} // namespace view
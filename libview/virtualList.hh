@@ -0,0 +1,140 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * virtualList.hh --
+ *
+ *      A scrolling list that only has widgets for the rows in view.
+ *
+ *      The rows come from a Model, which only has to know how many rows
+ *      there are. Row widgets are made by a factory slot and filled in by
+ *      a binder slot, and are recycled as rows scroll out of view. Row
+ *      heights are measured as rows are shown; the rest are estimated from
+ *      the average so far, so the list never measures every row.
+ */
+
+#ifndef LIBVIEW_VIRTUALLIST_HH
+#define LIBVIEW_VIRTUALLIST_HH
+
+
+#include <map>
+#include <vector>
+
+#include <gtkmm/fixed.h>
+
+#include <libview/viewport.hh>
+
+
+namespace view {
+
+
+class VirtualList
+   : public Viewport
+{
+public:
+   class Model
+   {
+   public:
+      virtual ~Model() {}
+
+      virtual size_t GetRowCount(void) const = 0;
+
+      // Rows were added, removed or reordered.
+      sigc::signal<void> rowsChanged;
+      // The contents of one row changed.
+      sigc::signal<void, size_t /* row */> rowChanged;
+   };
+
+   // Returns a new row widget, which the list takes ownership of.
+   typedef sigc::slot<Gtk::Widget *> RowFactory;
+   // Fills a row widget in with the contents of a row.
+   typedef sigc::slot<void, Gtk::Widget &, size_t /* row */> RowBinder;
+
+   VirtualList(Gtk::Adjustment &hadjustment, Gtk::Adjustment &vadjustment,
+               Model &model, const RowFactory &factory,
+               const RowBinder &binder);
+
+   void SetOverscan(unsigned int rows);
+   unsigned int GetOverscan(void) const { return mOverscan; }
+
+   void SetEstimatedRowHeight(int height);
+   int GetEstimatedRowHeight(void) const;
+
+   void ScrollToRow(size_t row);
+   Gtk::Widget *GetRowWidget(size_t row) const;
+   size_t GetShownRowCount(void) const { return mRows.size(); }
+
+protected:
+   void on_size_allocate(Gtk::Allocation &allocation);
+
+private:
+   struct Row {
+      Gtk::Widget *widget;
+      int y;
+   };
+   typedef std::map<size_t, Row> RowMap;
+
+   void OnRowsChanged(void);
+   void OnRowChanged(size_t row);
+   void OnScrolled(void);
+   void OnAdjustmentsSet(Gtk::Adjustment *hadjustment,
+                         Gtk::Adjustment *vadjustment);
+
+   void Layout(void);
+   Gtk::Widget *AcquireWidget(void);
+   void ReleaseRow(RowMap::iterator row);
+   void MeasureRow(size_t row, Gtk::Widget &widget);
+   void ForgetRowHeight(size_t row);
+   int GetRowY(size_t row) const;
+   size_t FindRow(int y) const;
+
+   Model &mModel;
+   RowFactory mFactory;
+   RowBinder mBinder;
+
+   Gtk::Fixed *mFixed;
+   RowMap mRows;
+   std::vector<Gtk::Widget *> mSpareWidgets;
+
+   unsigned int mOverscan;
+   int mEstimatedRowHeight;
+   int mRowWidth;
+   int mContentHeight;
+   bool mInLayout;
+   sigc::connection mScrolledConnection;
+
+   /*
+    * Measured row heights, 0 if not measured, with Fenwick trees over the
+    * heights and over which rows are measured, so that a row's position
+    * is found in O(log n) however many rows were measured.
+    */
+   std::vector<int> mHeights;
+   std::vector<long> mHeightTree;
+   std::vector<long> mMeasuredTree;
+};
+
+
+} // namespace view
+
+
+#endif // LIBVIEW_VIRTUALLIST_HH
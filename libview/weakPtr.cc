@@ -0,0 +1,137 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * weakPtr.cc --
+ *
+ *      Implements the table of weak reference slots behind view::WeakPtr.
+ */
+
+
+#include <libview/weakPtr.hh>
+
+
+namespace view {
+
+
+/*
+ * Slot 0 is never handed out, so a default Handle is always dead and a
+ * NULL hash table lookup can't be mistaken for a real index.
+ */
+std::vector<WeakRefTable::Slot> WeakRefTable::sSlots(1);
+guint WeakRefTable::sFreeSlot = 0;
+GHashTable *WeakRefTable::sIndex = NULL;
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WeakRefTable::Acquire --
+ *
+ *      Get a weak handle to a trackable. Every handle to the same object
+ *      shares one slot; the first one registers the destroy notify
+ *      callback that retires it.
+ *
+ * Results:
+ *      The handle, or a dead handle if trackable is NULL.
+ *
+ * Side effects:
+ *      May allocate a slot.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+WeakRefTable::Handle
+WeakRefTable::Acquire(sigc::trackable *trackable) // IN
+{
+   Handle handle;
+
+   if (!trackable) {
+      return handle;
+   }
+
+   if (!sIndex) {
+      sIndex = g_hash_table_new(g_direct_hash, g_direct_equal);
+   }
+
+   handle.index = GPOINTER_TO_UINT(g_hash_table_lookup(sIndex, trackable));
+   if (handle.index == 0) {
+      if (sFreeSlot != 0) {
+         handle.index = sFreeSlot;
+         sFreeSlot = sSlots[handle.index].nextFree;
+      } else {
+         Slot slot;
+         slot.generation = 1;
+         handle.index = sSlots.size();
+         sSlots.push_back(slot);
+      }
+
+      Slot &slot = sSlots[handle.index];
+      slot.trackable = trackable;
+      slot.nextFree = 0;
+
+      g_hash_table_insert(sIndex, trackable, GUINT_TO_POINTER(handle.index));
+      trackable->add_destroy_notify_callback(GUINT_TO_POINTER(handle.index),
+                                             &WeakRefTable::OnDestroyNotify);
+   }
+
+   handle.generation = sSlots[handle.index].generation;
+   return handle;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WeakRefTable::OnDestroyNotify --
+ *
+ *      Notification callback for destruction of a trackable with a slot.
+ *      Bumping the generation kills every outstanding handle at once.
+ *
+ * Results:
+ *      NULL.
+ *
+ * Side effects:
+ *      The slot is put back on the free list.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void *
+WeakRefTable::OnDestroyNotify(void *data) // IN: Slot index
+{
+   guint index = GPOINTER_TO_UINT(data);
+   Slot &slot = sSlots[index];
+
+   g_hash_table_remove(sIndex, slot.trackable);
+
+   slot.trackable = NULL;
+   slot.generation++;
+   slot.nextFree = sFreeSlot;
+   sFreeSlot = index;
+
+   return NULL;
+}
+
+
+} // namespace view
@@ -26,35 +26,51 @@
  * weakPtr.hh --
  *
  *      The WeakPtr is a simple weak pointer implementation for classes
- *      that inherit from sigc::trackable. It will automatically set itself to
- *      NULL when the object it tracks is destroyed.
+ *      that inherit from sigc::trackable. It will automatically read as
+ *      NULL once the object it tracks is destroyed.
+ *
+ *      Weak references are handles into a process-wide table with one
+ *      generation-counted slot per tracked object. The object gets a
+ *      single destroy notify callback, registered the first time it is
+ *      weakly referenced, which retires its slot. Creating, copying and
+ *      checking a WeakPtr is O(1) and never touches the trackable.
  */
 
 #ifndef LIBVIEW_WEAKPTR_HH
 #define LIBVIEW_WEAKPTR_HH
 
 
+#include <vector>
+#include <glib.h>
+#include <sigc++/trackable.h>
+
+
 namespace view {
 
 
-template<class T>
-class WeakPtr
+class WeakRefTable
 {
 public:
+   struct Handle
+   {
+      Handle() : index(0), generation(0) {}
+
+      guint index;
+      guint generation;
+   };
+
+   static Handle Acquire(sigc::trackable *trackable);
+
+
    /*
     *------------------------------------------------------------------------
     *
-    * view::WeakPtr::WeakPtr --
-    *
-    *      Constructors.
+    * view::WeakRefTable::IsAlive --
     *
-    *      The default constructor creates a weak pointer that just points
-    *      to NULL. The typical constructor takes a raw trackable pointer
-    *      and is explicit to avoid ambiguity problems.
-    *      Copy constructor is standard fair.
+    *      Check whether the object a handle was acquired for still exists.
     *
     * Results:
-    *      None.
+    *      true if it does, false if it was destroyed or the handle is null.
     *
     * Side effects:
     *      None.
@@ -62,17 +78,43 @@ public:
     *------------------------------------------------------------------------
     */
 
-   inline WeakPtr() : mTrackable(0) {}
-   inline explicit WeakPtr(T *trackable) : mTrackable(trackable) { Init(); }
-   inline WeakPtr(const WeakPtr<T> &src) : mTrackable(src.mTrackable) { Init(); }
+   static inline bool IsAlive(const Handle &handle)
+   {
+      return handle.index != 0 &&
+             sSlots[handle.index].generation == handle.generation;
+   }
 
+private:
+   struct Slot
+   {
+      sigc::trackable *trackable;
+      guint generation;
+      guint nextFree;
+   };
 
+   static void *OnDestroyNotify(void *data);
+
+   static std::vector<Slot> sSlots;
+   static guint sFreeSlot;
+   static GHashTable *sIndex;
+};
+
+
+template<class T>
+class WeakPtr
+{
+public:
    /*
     *------------------------------------------------------------------------
     *
-    * view::WeakPtr::~WeakPtr --
+    * view::WeakPtr::WeakPtr --
+    *
+    *      Constructors.
     *
-    *      Destructor.
+    *      The default constructor creates a weak pointer that just points
+    *      to NULL. The typical constructor takes a raw trackable pointer
+    *      and is explicit to avoid ambiguity problems.
+    *      Copying only copies the handle.
     *
     * Results:
     *      None.
@@ -83,12 +125,23 @@ public:
     *------------------------------------------------------------------------
     */
 
-   inline ~WeakPtr()
+   inline WeakPtr() : mTrackable(0) {}
+   inline explicit WeakPtr(T *trackable)
+      : mTrackable(trackable),
+        mHandle(WeakRefTable::Acquire(trackable)) {}
+   inline WeakPtr(const WeakPtr<T> &src)
+      : mTrackable(src.mTrackable),
+        mHandle(src.mHandle) {}
+
+#if __cplusplus >= 201103L
+   inline WeakPtr(WeakPtr<T> &&src)
+      : mTrackable(src.mTrackable),
+        mHandle(src.mHandle)
    {
-      if (mTrackable) {
-         mTrackable->remove_destroy_notify_callback(&mTrackable);
-      }
+      src.mTrackable = 0;
+      src.mHandle = WeakRefTable::Handle();
    }
+#endif
 
 
    /*
@@ -111,16 +164,27 @@ public:
    inline WeakPtr<T> &operator=(T *trackable)
    {
       mTrackable = trackable;
-      Init();
+      mHandle = WeakRefTable::Acquire(trackable);
       return *this;
    }
 
    inline WeakPtr<T> &operator=(const WeakPtr<T> &src)
    {
       mTrackable = src.mTrackable;
-      Init();
+      mHandle = src.mHandle;
+      return *this;
+   }
+
+#if __cplusplus >= 201103L
+   inline WeakPtr<T> &operator=(WeakPtr<T> &&src)
+   {
+      mTrackable = src.mTrackable;
+      mHandle = src.mHandle;
+      src.mTrackable = 0;
+      src.mHandle = WeakRefTable::Handle();
       return *this;
    }
+#endif
 
 
    /*
@@ -141,7 +205,7 @@ public:
 
    inline bool operator==(const WeakPtr<T> &src) const 
    {
-      return (mTrackable == src.mTrackable);
+      return (Get() == src.Get());
    }
 
 
@@ -163,7 +227,7 @@ public:
 
    inline bool operator!=(const WeakPtr<T> &src) const
    {
-      return (mTrackable != src.mTrackable);
+      return (Get() != src.Get());
    }
 
 
@@ -183,7 +247,7 @@ public:
     *------------------------------------------------------------------------
     */
 
-   inline operator T*() const { return mTrackable; }
+   inline operator T*() const { return Get(); }
 
 
    /*
@@ -202,7 +266,7 @@ public:
     *------------------------------------------------------------------------
     */
 
-   inline T *operator->() const { return mTrackable; }
+   inline T *operator->() const { return Get(); }
 
 
    /*
@@ -221,7 +285,7 @@ public:
     *------------------------------------------------------------------------
     */
 
-   inline T &operator*() const { return *mTrackable; }
+   inline T &operator*() const { return *Get(); }
 
 
    /*
@@ -240,50 +304,24 @@ public:
     *------------------------------------------------------------------------
     */
 
-   inline operator bool() const { return (mTrackable != NULL); }
+   inline operator bool() const { return (Get() != NULL); }
    inline bool operator!() const { return !operator bool(); }
 
 
 private:
    T *mTrackable;
+   WeakRefTable::Handle mHandle;
 
 
    /*
     *------------------------------------------------------------------------
     *
-    * view::WeakPtr::OnDestroyNotify --
+    * view::WeakPtr::Get --
     *
-    *      Notification callback for destruction of trackable object that
-    *      WeakPtr is pointing to. The WeakPtr will be reset to point to NULL.
+    *      Resolve the weak pointer.
     *
     * Results:
-    *      None.
-    *
-    * Side effects:
-    *      None.
-    *
-    *------------------------------------------------------------------------
-    */
-
-   inline static void *OnDestroyNotify(void *data)
-   {
-      T **trackable = reinterpret_cast<T **>(data);
-
-      *trackable = NULL;
-      return NULL;
-   }
-
-
-   /*
-    *------------------------------------------------------------------------
-    *
-    * view::WeakPtr::Init --
-    *
-    *      Initialise the WeakPtr by attaching a destroy notify callback to the
-    *      pointed-to trackable object.
-    *
-    * Results:
-    *      None.
+    *      The raw T*, or NULL if it has been destroyed.
     *
     * Side effects:
     *      None.
@@ -291,12 +329,9 @@ private:
     *------------------------------------------------------------------------
     */
 
-   inline void Init()
+   inline T *Get() const
    {
-      if (mTrackable) {
-         mTrackable->add_destroy_notify_callback(&mTrackable,
-                                                 &WeakPtr::OnDestroyNotify);
-      }
+      return WeakRefTable::IsAlive(mHandle) ? mTrackable : NULL;
    }
 };
 
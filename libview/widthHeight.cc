@@ -28,6 +28,9 @@
  */
 
 
+#include <algorithm>
+#include <glibmm/main.h>
+
 #include <libview/widthHeight.hh>
 
 
@@ -54,8 +57,31 @@ WidthHeight::WidthHeight(Dimension driving,     // IN: The driving dimension
                          size_t minDrivingSize) // IN: The minimum driving size
    : mDriving(driving),
      mMinDrivingSize(minDrivingSize),
-     mDrivenSize(0)
+     mDrivenSize(0),
+     mForceDrivingSizeChanged(false)
+{
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WidthHeight::~WidthHeight --
+ *
+ *      Destructor of a WidthHeight.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+WidthHeight::~WidthHeight()
 {
+   mResizeIdle.disconnect();
 }
 
 
@@ -86,6 +112,41 @@ WidthHeight::SetDrivenSize(size_t size) // IN
 }
 
 
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WidthHeight::SetDrivenSizeFunc --
+ *
+ *      Set a function that computes the driven size from the driving size.
+ *
+ *      When set, the driven size is resolved synchronously while the
+ *      WidthHeight is being allocated, before the child is allocated.
+ *      Clients no longer need to round-trip through drivingSizeChanged and
+ *      SetDrivenSize, and a resize is only queued when the driven size
+ *      actually changes.
+ *
+ *      Pass an empty slot to go back to manual SetDrivenSize calls.
+ *
+ * Results:
+ *      None
+ *
+ * Side effects:
+ *      May queue a resize.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+WidthHeight::SetDrivenSizeFunc(const DrivenSizeFunc &func) // IN
+{
+   mDrivenSizeFunc = func;
+   if (mDrivenSizeFunc) {
+      SetDrivenSize(mDrivenSizeFunc(std::max(GetDrivingSize(),
+                                             mMinDrivingSize)));
+   }
+}
+
+
 /*
  *-----------------------------------------------------------------------------
  *
@@ -110,6 +171,16 @@ WidthHeight::on_size_request(Gtk::Requisition *requisition) // OUT
       child->size_request(*requisition);
    }
 
+   /*
+    * Resolve the driven size against the driving size we were last
+    * allocated, so that the requisition is already right whenever the
+    * driving size does not change.
+    */
+   if (mDrivenSizeFunc) {
+      mDrivenSize = mDrivenSizeFunc(std::max(GetDrivingSize(),
+                                             mMinDrivingSize));
+   }
+
    switch (mDriving) {
    case WIDTH:
       requisition->width = mMinDrivingSize;
@@ -145,30 +216,54 @@ WidthHeight::on_size_request(Gtk::Requisition *requisition) // OUT
 void
 WidthHeight::on_size_allocate(Gtk::Allocation &allocation) // IN
 {
-   bool changed = false;
-
-   if (mForceDrivingSizeChanged) {
-      changed = true;
-      mForceDrivingSizeChanged = false;
-   } else {
-      switch (mDriving) {
-      case WIDTH:
-         changed = allocation.get_width() != get_allocation().get_width();
-         break;
-      case HEIGHT:
-         changed = allocation.get_height() != get_allocation().get_height();
-         break;
-      default:
-         g_assert_not_reached();
-         break;
-      }
-   }
+   bool changed = mForceDrivingSizeChanged ||
+                  GetDrivingSize(allocation) != GetDrivingSize();
+   mForceDrivingSizeChanged = false;
 
    set_allocation(allocation);
 
+   /*
+    * Resolve the driven size from this allocation before the child is
+    * allocated, and hand the child that size right away, so it (and any
+    * WidthHeight nested inside it) lays out for the new driving size in
+    * this same pass. GTK+ 2 has no height-for-width negotiation, so our
+    * own parent can only learn the new size through another request:
+    * queueing a resize from inside size_allocate would restart the layout
+    * pass, so it is asked for from an idle.
+    */
+   if (changed && mDrivenSizeFunc) {
+      size_t drivenSize = mDrivenSizeFunc(GetDrivingSize(allocation));
+      if (drivenSize != mDrivenSize) {
+         mDrivenSize = drivenSize;
+         if (!mResizeIdle.connected()) {
+            mResizeIdle = Glib::signal_idle().connect(
+               sigc::mem_fun(this, &WidthHeight::OnResizeIdle),
+               Glib::PRIORITY_HIGH_IDLE);
+         }
+      }
+   }
+
    Gtk::Widget *child = get_child();
    if (child && child->is_visible()) {
-      child->size_allocate(allocation);
+      Gtk::Allocation childAllocation = allocation;
+
+      if (mDrivenSizeFunc) {
+         switch (mDriving) {
+         case WIDTH:
+            childAllocation.set_height(
+               std::max(allocation.get_height(), (int)mDrivenSize));
+            break;
+         case HEIGHT:
+            childAllocation.set_width(
+               std::max(allocation.get_width(), (int)mDrivenSize));
+            break;
+         default:
+            g_assert_not_reached();
+            break;
+         }
+      }
+
+      child->size_allocate(childAllocation);
    }
 
    if (changed) {
@@ -177,6 +272,32 @@ WidthHeight::on_size_allocate(Gtk::Allocation &allocation) // IN
 }
 
 
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WidthHeight::OnResizeIdle --
+ *
+ *      Idle callback that asks our parent for the driven size stored by
+ *      on_size_allocate. It runs ahead of GTK+'s resize handler, so the
+ *      new size still takes effect before the next redraw.
+ *
+ * Results:
+ *      false to remove the idle.
+ *
+ * Side effects:
+ *      Queues a resize.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+bool
+WidthHeight::OnResizeIdle(void)
+{
+   queue_resize();
+   return false;
+}
+
+
 /*
  *-----------------------------------------------------------------------------
  *
@@ -220,12 +341,36 @@ WidthHeight::on_add(Gtk::Widget *widget) // IN
 size_t
 WidthHeight::GetDrivingSize(void)
    const
+{
+   return GetDrivingSize(get_allocation());
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WidthHeight::GetDrivingSize --
+ *
+ *      Retrieve the driving size of an allocation.
+ *
+ * Results:
+ *      The driving size
+ *
+ * Side effects:
+ *      None
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+size_t
+WidthHeight::GetDrivingSize(const Gtk::Allocation &allocation) // IN
+   const
 {
    switch (mDriving) {
    case WIDTH:
-      return get_allocation().get_width();
+      return allocation.get_width();
    case HEIGHT:
-      return get_allocation().get_height();
+      return allocation.get_height();
    default:
       g_assert_not_reached();
       return 0;
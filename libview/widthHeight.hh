@@ -33,7 +33,9 @@
 
 
 #include <gtkmm/bin.h>
+#include <sigc++/connection.h>
 #include <sigc++/signal.h>
+#include <sigc++/slot.h>
 
 
 namespace view {
@@ -48,9 +50,14 @@ public:
       HEIGHT,
    };
 
+   /* Maps a driving size to the driven size it requires. */
+   typedef sigc::slot<size_t, size_t> DrivenSizeFunc;
+
    WidthHeight(Dimension driving, size_t minDrivingSize);
+   ~WidthHeight();
    size_t GetDrivingSize(void) const;
    void SetDrivenSize(size_t size);
+   void SetDrivenSizeFunc(const DrivenSizeFunc &func);
 
    /* This signal is never emitted spuriously. */
    sigc::signal<void> drivingSizeChanged;
@@ -61,10 +68,15 @@ protected:
    void on_add(Gtk::Widget *widget);
 
 private:
+   size_t GetDrivingSize(const Gtk::Allocation &allocation) const;
+   bool OnResizeIdle(void);
+
    Dimension mDriving;
    size_t const mMinDrivingSize;
    size_t mDrivenSize;
    bool mForceDrivingSizeChanged;
+   DrivenSizeFunc mDrivenSizeFunc;
+   sigc::connection mResizeIdle;
 };
 
 
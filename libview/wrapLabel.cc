@@ -21,6 +21,10 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  * *************************************************************************/
 
+#include <algorithm>
+#include <glibmm/main.h>
+#include <gtk/gtklabel.h>
+
 #include <libview/wrapLabel.hh>
 
 
@@ -31,6 +35,9 @@
  */
 
 
+#define MAX_CACHED_HEIGHTS 8
+
+
 namespace view {
 
 
@@ -52,7 +59,11 @@ namespace view {
 
 WrapLabel::WrapLabel(const Glib::ustring &text) // IN: The label text
    : mWrapWidth(0),
-     mWrapHeight(0)
+     mWrapHeight(0),
+     mMaxLines(0),
+     mMaxLength(0),
+     mIsMarkup(false),
+     mBoundedMarkup(false)
 {
    get_layout()->set_wrap(Pango::WRAP_WORD_CHAR);
    set_alignment(0.0, 0.0);
@@ -60,13 +71,36 @@ WrapLabel::WrapLabel(const Glib::ustring &text) // IN: The label text
 }
 
 
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WrapLabel::~WrapLabel --
+ *
+ *      Destructor.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+WrapLabel::~WrapLabel()
+{
+   mResizeIdle.disconnect();
+}
+
+
 /*
  *-----------------------------------------------------------------------------
  *
  * view::WrapLabel::set_text --
  *
  *      Override function for Label::set_text() that re-sets the wrapping
- *      width after the text is set.
+ *      width after the text is set. The text is cut down to the bounds set
+ *      with SetMaxLines and SetMaxLength first.
  *
  * Results:
  *      None.
@@ -80,9 +114,19 @@ WrapLabel::WrapLabel(const Glib::ustring &text) // IN: The label text
 void
 WrapLabel::set_text(const Glib::ustring &str) // IN: The text to set
 {
-   Label::set_text(str);
+   mText = str;
+   mIsMarkup = false;
+   mHeights.clear();
+
+   if (mBoundedMarkup) {
+      gtk_label_set_attributes(gobj(), NULL);
+      mBoundedMarkup = false;
+   }
+   Label::set_text(BoundText(str));
 
-   SetWrapWidth(mWrapWidth);
+   if (SetWrapWidth(mWrapWidth)) {
+      queue_resize();
+   }
 }
 
 
@@ -92,7 +136,8 @@ WrapLabel::set_text(const Glib::ustring &str) // IN: The text to set
  * view::WrapLabel::set_markup --
  *
  *      Override function for Label::set_markup() that re-sets the wrapping
- *      width after the text is set.
+ *      width after the text is set. The text is cut down to the bounds set
+ *      with SetMaxLines and SetMaxLength first.
  *
  * Results:
  *      None.
@@ -106,9 +151,364 @@ WrapLabel::set_text(const Glib::ustring &str) // IN: The text to set
 void
 WrapLabel::set_markup(const Glib::ustring &str) // IN: The text to set
 {
-   Label::set_markup(str);
+   mText = str;
+   mIsMarkup = true;
+   mHeights.clear();
+
+   if (mBoundedMarkup) {
+      gtk_label_set_attributes(gobj(), NULL);
+      mBoundedMarkup = false;
+   }
+
+   if (mMaxLines == 0 && mMaxLength == 0) {
+      Label::set_markup(str);
+   } else {
+      /*
+       * Cutting the markup itself could split a tag, so parse it and bound
+       * the plain text instead. Attributes past the end of the text are
+       * ignored by Pango.
+       */
+      PangoAttrList *attrs = NULL;
+      char *text = NULL;
+      GError *error = NULL;
+
+      if (!pango_parse_markup(str.c_str(), -1, 0, &attrs, &text, NULL,
+                              &error)) {
+         g_warning("Failed to parse WrapLabel markup: %s", error->message);
+         g_error_free(error);
+         Label::set_text(BoundText(str));
+      } else {
+         Label::set_text(BoundText(text));
+         gtk_label_set_attributes(gobj(), attrs);
+         pango_attr_list_unref(attrs);
+         mBoundedMarkup = true;
+         g_free(text);
+      }
+   }
+
+   if (SetWrapWidth(mWrapWidth)) {
+      queue_resize();
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WrapLabel::SetMaxLines --
+ *
+ *      Limits the label to the given number of lines, ellipsizing the last
+ *      one. Paragraphs past the limit are dropped before they reach Pango,
+ *      and so is any text past what that many lines as wide as the screen
+ *      could show, so the layout cost does not grow with the length of the
+ *      text.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      The current text is bounded again.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+WrapLabel::SetMaxLines(int lines) // IN: Maximum lines, or 0 for no limit
+{
+   lines = std::max(lines, 0);
+   if (mMaxLines != lines) {
+      mMaxLines = lines;
+      Rebound();
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WrapLabel::SetMaxLength --
+ *
+ *      Limits the label to the given number of characters. Longer text is
+ *      cut and ended with an ellipsis before it is laid out.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      The current text is bounded again.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+WrapLabel::SetMaxLength(int length) // IN: Maximum characters, or 0 for none
+{
+   length = std::max(length, 0);
+   if (mMaxLength != length) {
+      mMaxLength = length;
+      Rebound();
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WrapLabel::Rebound --
+ *
+ *      Sets the text last given to set_text or set_markup again, so that it
+ *      is cut down to the current bounds.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+WrapLabel::Rebound(void)
+{
+   Glib::ustring text = mText;
+
+   if (mIsMarkup) {
+      set_markup(text);
+   } else {
+      set_text(text);
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WrapLabel::GetLinesLength --
+ *
+ *      Estimates how many characters mMaxLines lines can hold. The wrap
+ *      width changes with every allocation, so the width of the screen is
+ *      used instead, and the font's average character width is halved to
+ *      allow for narrow glyphs.
+ *
+ * Results:
+ *      The number of characters, or 0 if there is no line limit.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+int
+WrapLabel::GetLinesLength(void)
+{
+   if (mMaxLines == 0) {
+      return 0;
+   }
+
+   Glib::RefPtr<Pango::Context> context = get_pango_context();
+   Pango::FontMetrics metrics =
+      context->get_metrics(context->get_font_description());
+   int charWidth = std::max(metrics.get_approximate_char_width() /
+                            Pango::SCALE / 2, 1);
+
+   return mMaxLines * (get_screen()->get_width() / charWidth + 1);
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WrapLabel::BoundText --
+ *
+ *      Cuts text down to at most mMaxLines paragraphs, and to at most
+ *      mMaxLength characters or as many as mMaxLines lines can hold,
+ *      whichever is fewer.
+ *
+ * Results:
+ *      The bounded text, ending with an ellipsis if anything but a final
+ *      newline was cut.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+Glib::ustring
+WrapLabel::BoundText(const Glib::ustring &text) // IN: The text to bound
+{
+   const std::string &raw = text.raw();
+   std::string::size_type end = raw.size();
+
+   if (mMaxLines > 0) {
+      std::string::size_type pos = 0;
+      int lines = 0;
+
+      while ((pos = raw.find('\n', pos)) != std::string::npos) {
+         if (++lines == mMaxLines) {
+            end = pos;
+            break;
+         }
+         pos++;
+      }
+   }
+
+   int maxLength = GetLinesLength();
+   if (mMaxLength > 0 && (maxLength == 0 || mMaxLength < maxLength)) {
+      maxLength = mMaxLength;
+   }
+
+   if (maxLength > 0) {
+      const char *start = raw.c_str();
+      const char *p = start;
+
+      for (int i = 0; i < maxLength && p < start + end; i++) {
+         p = g_utf8_next_char(p);
+      }
+      end = std::min(end, static_cast<std::string::size_type>(p - start));
+   }
+
+   if (end >= raw.size()) {
+      return text;
+   }
+   if (end == raw.size() - 1 && raw[end] == '\n') {
+      return raw.substr(0, end);
+   }
+
+   return raw.substr(0, end) + "\xe2\x80\xa6"; // U+2026 HORIZONTAL ELLIPSIS
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WrapLabel::BoundLines --
+ *
+ *      Ellipsizes layout after mMaxLines lines. BoundText already keeps
+ *      at most mMaxLines paragraphs, but each of those can still wrap.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+WrapLabel::BoundLines(PangoLayout *layout) // IN: Our layout or a copy
+   const
+{
+#if PANGO_VERSION_CHECK(1, 20, 0)
+   if (mMaxLines == 0) {
+      pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_NONE);
+      pango_layout_set_height(layout, -1);
+      return;
+   }
+
+   pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
+   pango_layout_set_height(layout, -mMaxLines);
+
+   /*
+    * A negative height limits the lines of each paragraph. If several
+    * paragraphs add up to too many lines, limit the total height to the
+    * bottom of the last line we want instead.
+    */
+   if (pango_layout_get_line_count(layout) > mMaxLines) {
+      PangoLayoutIter *iter = pango_layout_get_iter(layout);
+      int y0;
+      int y1;
+
+      for (int i = 1; i < mMaxLines; i++) {
+         pango_layout_iter_next_line(iter);
+      }
+      pango_layout_iter_get_line_yrange(iter, &y0, &y1);
+      pango_layout_iter_free(iter);
+
+      pango_layout_set_height(layout, y1);
+   }
+#endif
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WrapLabel::GetHeightForWidth --
+ *
+ *      Returns the height the label needs when wrapped at the given width.
+ *      Suitable as a view::WidthHeight::DrivenSizeFunc, so that a
+ *      WidthHeight around a WrapLabel resolves its height in the same
+ *      allocation pass that sets its width.
+ *
+ *      Any width other than the current wrap width is measured on a copy
+ *      of the layout, which is left alone. Those heights are cached until
+ *      the text or style changes, since size requests ask for the same
+ *      few widths over and over.
+ *
+ * Results:
+ *      The height of the label when wrapped at width.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+int
+WrapLabel::GetHeightForWidth(int width) // IN: The wrap width
+   const
+{
+   if (width == mWrapWidth) {
+      return mWrapHeight;
+   }
+
+   std::map<int, int>::const_iterator cached = mHeights.find(width);
+   if (cached != mHeights.end()) {
+      return cached->second;
+   }
+
+   Glib::RefPtr<Pango::Layout> layout = get_layout()->copy();
+   layout->set_width(width * Pango::SCALE);
+   BoundLines(layout->gobj());
+
+   int unused;
+   int height;
+   layout->get_pixel_size(unused, height);
 
-   SetWrapWidth(mWrapWidth);
+   if (mHeights.size() >= MAX_CACHED_HEIGHTS) {
+      mHeights.clear();
+   }
+   mHeights[width] = height;
+   return height;
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WrapLabel::on_style_changed --
+ *
+ *      Override handler for the "style_changed" signal. A new font changes
+ *      the height at every width.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      None.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+void
+WrapLabel::on_style_changed(const Glib::RefPtr<Gtk::Style> &previousStyle) // IN
+{
+   mHeights.clear();
+   Gtk::Label::on_style_changed(previousStyle);
 }
 
 
@@ -160,7 +560,43 @@ WrapLabel::on_size_allocate(Gtk::Allocation &alloc) // IN: Our allocation
 {
    Gtk::Label::on_size_allocate(alloc);
 
-   SetWrapWidth(alloc.get_width());
+   /*
+    * Queueing a resize from inside size_allocate would restart the layout
+    * pass, so a new height is requested from an idle instead. When a
+    * WidthHeight already asked GetHeightForWidth, the height matches and
+    * nothing is queued.
+    */
+   if (SetWrapWidth(alloc.get_width()) && !mResizeIdle.connected()) {
+      mResizeIdle = Glib::signal_idle().connect(
+         sigc::mem_fun(this, &WrapLabel::OnResizeIdle),
+         Glib::PRIORITY_HIGH_IDLE);
+   }
+}
+
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * view::WrapLabel::OnResizeIdle --
+ *
+ *      Idle callback that requests the height on_size_allocate found. It
+ *      runs ahead of GTK+'s resize handler, so the new height still takes
+ *      effect before the next redraw.
+ *
+ * Results:
+ *      false to remove the idle.
+ *
+ * Side effects:
+ *      Queues a resize.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+bool
+WrapLabel::OnResizeIdle(void)
+{
+   queue_resize();
+   return false;
 }
 
 
@@ -172,7 +608,8 @@ WrapLabel::on_size_allocate(Gtk::Allocation &alloc) // IN: Our allocation
  *      Sets the point at which the text should wrap.
  *
  * Results:
- *      None.
+ *      true if the wrapped height changed. Our requested width is always 0,
+ *      so a new width alone does not need another size request.
  *
  * Side effects:
  *      None.
@@ -180,11 +617,11 @@ WrapLabel::on_size_allocate(Gtk::Allocation &alloc) // IN: Our allocation
  *-----------------------------------------------------------------------------
  */
 
-void
+bool
 WrapLabel::SetWrapWidth(int width) // IN: The wrap width
 {
    if (width == 0) {
-      return;
+      return false;
    }
 
    /*
@@ -192,14 +629,18 @@ WrapLabel::SetWrapWidth(int width) // IN: The wrap width
     * or not we've changed the width.
     */
    get_layout()->set_width(width * Pango::SCALE);
+   BoundLines(get_layout()->gobj());
 
    int unused;
-   get_layout()->get_pixel_size(unused, mWrapHeight);
+   int height;
+   get_layout()->get_pixel_size(unused, height);
 
-   if (mWrapWidth != width) {
-      mWrapWidth = width;
-      queue_resize();
+   mWrapWidth = width;
+   if (mWrapHeight == height) {
+      return false;
    }
+   mWrapHeight = height;
+   return true;
 }
 
 
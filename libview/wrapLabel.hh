@@ -25,6 +25,7 @@
 #define LIBVIEW_WRAP_LABEL_HH
 
 
+#include <map>
 #include <gtkmm/label.h>
 
 
@@ -36,19 +37,40 @@ class WrapLabel
 {
 public:
    WrapLabel(const Glib::ustring &text = "");
+   ~WrapLabel();
 
    void set_text(const Glib::ustring &str);
    void set_markup(const Glib::ustring &str);
 
+   int GetHeightForWidth(int width) const;
+
+   void SetMaxLines(int lines);
+   void SetMaxLength(int length);
+
 protected:
    virtual void on_size_allocate(Gtk::Allocation &alloc);
    virtual void on_size_request(Gtk::Requisition *req);
+   virtual void on_style_changed(const Glib::RefPtr<Gtk::Style> &previousStyle);
 
 private:
-   void SetWrapWidth(int width);
+   bool SetWrapWidth(int width);
+   bool OnResizeIdle(void);
+   void BoundLines(PangoLayout *layout) const;
+   void Rebound(void);
+   int GetLinesLength(void);
+   Glib::ustring BoundText(const Glib::ustring &text);
 
    int mWrapWidth;
    int mWrapHeight;
+   int mMaxLines;
+   int mMaxLength;
+   Glib::ustring mText;
+   bool mIsMarkup;
+   bool mBoundedMarkup;
+   sigc::connection mResizeIdle;
+
+   // Heights at widths other than mWrapWidth, from GetHeightForWidth.
+   mutable std::map<int, int> mHeights;
 };
 
 
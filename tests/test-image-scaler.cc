@@ -0,0 +1,158 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+/*
+ * test-image-scaler.cc
+ *
+ *      A test program for view::ImageScaler. Checks that every SIMD
+ *      kernel the CPU supports produces exactly the scalar kernel's
+ *      pixels, then times ImageScaler::ScaleSimple against
+ *      Gdk::Pixbuf::scale_simple on spinner-sized images.
+ */
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <glibmm/init.h>
+#include <gdkmm/wrap_init.h>
+#include <libview/imageScaler.hh>
+
+
+static const char *sKernelNames[] = { "auto", "scalar", "sse2", "avx2" };
+static const char *sFilterNames[] = { "box", "bilinear" };
+
+
+static int
+CheckExactness(void)
+{
+   static const int sizes[][4] = {
+      { 48, 48, 16, 16 },
+      { 32, 32, 22, 22 },
+      { 384, 48, 128, 16 },
+      { 97, 61, 24, 24 },
+      { 5, 3, 17, 9 },
+      { 300, 1, 33, 1 },
+      { 64, 64, 64, 64 },
+   };
+   int failures = 0;
+
+   for (size_t i = 0; i < G_N_ELEMENTS(sizes); i++) {
+      int srcW = sizes[i][0];
+      int srcH = sizes[i][1];
+      int dstW = sizes[i][2];
+      int dstH = sizes[i][3];
+
+      std::vector<guint8> src(srcW * srcH * 4);
+      for (size_t j = 0; j < src.size(); j++) {
+         src[j] = rand();
+      }
+
+      for (int f = view::ImageScaler::FILTER_BOX;
+           f <= view::ImageScaler::FILTER_BILINEAR; f++) {
+         view::ImageScaler::Filter filter = (view::ImageScaler::Filter)f;
+         std::vector<guint8> expected(dstW * dstH * 4);
+         view::ImageScaler::Scale(&src[0], srcW, srcH, srcW * 4,
+                                  &expected[0], dstW, dstH, dstW * 4,
+                                  filter, view::ImageScaler::KERNEL_SCALAR);
+
+         for (int k = view::ImageScaler::KERNEL_SSE2;
+              k <= view::ImageScaler::KERNEL_AVX2; k++) {
+            view::ImageScaler::Kernel kernel = (view::ImageScaler::Kernel)k;
+            if (!view::ImageScaler::IsKernelSupported(kernel)) {
+               continue;
+            }
+
+            std::vector<guint8> actual(dstW * dstH * 4);
+            view::ImageScaler::Scale(&src[0], srcW, srcH, srcW * 4,
+                                     &actual[0], dstW, dstH, dstW * 4,
+                                     filter, kernel);
+            bool same = actual == expected;
+            printf("%3dx%-3d -> %3dx%-3d %-8s %-6s %s\n", srcW, srcH, dstW,
+                   dstH, sFilterNames[f], sKernelNames[k],
+                   same ? "ok" : "MISMATCH");
+            failures += !same;
+         }
+      }
+   }
+
+   return failures;
+}
+
+
+static void
+Benchmark(int srcW,       // IN:
+          int srcH,       // IN:
+          int dstW,       // IN:
+          int dstH,       // IN:
+          int iterations) // IN:
+{
+   Glib::RefPtr<Gdk::Pixbuf> src =
+      Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, true, 8, srcW, srcH);
+   guint8 *pixels = src->get_pixels();
+   for (int y = 0; y < srcH; y++) {
+      for (int x = 0; x < srcW * 4; x++) {
+         pixels[y * src->get_rowstride() + x] = rand();
+      }
+   }
+
+   GTimer *timer = g_timer_new();
+   for (int i = 0; i < iterations; i++) {
+      src->scale_simple(dstW, dstH, Gdk::INTERP_BILINEAR);
+   }
+   double gdk = g_timer_elapsed(timer, NULL);
+
+   g_timer_start(timer);
+   for (int i = 0; i < iterations; i++) {
+      view::ImageScaler::ScaleSimple(src, dstW, dstH);
+   }
+   double ours = g_timer_elapsed(timer, NULL);
+   g_timer_destroy(timer);
+
+   printf("%3dx%-3d -> %3dx%-3d gdk-pixbuf %8.2f us  ImageScaler (%s) %8.2f us\n",
+          srcW, srcH, dstW, dstH, gdk * 1e6 / iterations,
+          sKernelNames[view::ImageScaler::GetBestKernel()],
+          ours * 1e6 / iterations);
+}
+
+
+int
+main(int argc,     // IN:
+     char *argv[]) // IN:
+{
+   /*
+    * Only pixbufs are used, so set up the type system and the gdkmm
+    * wrappers without opening a display.
+    */
+   Glib::init();
+   Gdk::wrap_init();
+
+   int failures = CheckExactness();
+
+   Benchmark(48, 48, 16, 16, 20000);
+   Benchmark(384, 48, 128, 16, 2000);
+   Benchmark(256, 256, 24, 24, 500);
+   Benchmark(16, 16, 48, 48, 5000);
+
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,328 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+/*
+ * test-main-thread-dispatcher.cc
+ *
+ *      A test program for view::MainThreadDispatcher. Several threads
+ *      post to the same updates at once while the main loop applies
+ *      them, and then the main thread checks that updates are applied in
+ *      the order they were first queued and that destroying a queued
+ *      update cancels it, wherever it is in the queue.
+ */
+
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+#include <glibmm/init.h>
+#include <glibmm/main.h>
+#include <libview/mainThreadDispatcher.hh>
+
+
+#define N_PRODUCERS 4
+#define N_PROPERTIES 8
+#define N_POSTS 100000
+
+
+// The thread a value was posted from, and the index of the post.
+typedef std::pair<int, int> Post;
+typedef view::MainThreadDispatcher::Property<Post> PostProperty;
+typedef view::MainThreadDispatcher::Trigger Trigger;
+
+
+static int sFailures = 0;
+
+
+static void
+Check(bool ok,          // IN:
+      const char *what) // IN:
+{
+   printf("%-60s %s\n", what, ok ? "ok" : "FAILED");
+   sFailures += !ok;
+}
+
+
+class Stress
+{
+public:
+   Stress();
+   ~Stress();
+
+   void Run(void);
+
+private:
+   void Produce(int producer);
+   void OnProducerDone(void);
+   void OnSet(const Post &post, int property);
+   void OnFired(void);
+
+   static int GetLastPost(int producer, int property);
+
+   Trigger mTrigger;
+   std::vector<PostProperty *> mProperties;
+   Glib::Dispatcher mDone;
+   Glib::RefPtr<Glib::MainLoop> mLoop;
+   std::vector<Glib::Thread *> mThreads;
+   int mRunning;
+
+   // Last post applied from each producer, per property.
+   std::vector<std::vector<int> > mSeen;
+   std::vector<Post> mLatest;
+   bool mOrdered;
+   int mApplied;
+   int mFired;
+};
+
+
+Stress::Stress()
+   : mTrigger(sigc::mem_fun(this, &Stress::OnFired)),
+     mLoop(Glib::MainLoop::create()),
+     mRunning(0),
+     mSeen(N_PROPERTIES, std::vector<int>(N_PRODUCERS, -1)),
+     mLatest(N_PROPERTIES, Post(-1, -1)),
+     mOrdered(true),
+     mApplied(0),
+     mFired(0)
+{
+   for (int i = 0; i < N_PROPERTIES; i++) {
+      mProperties.push_back(new PostProperty(
+         sigc::bind(sigc::mem_fun(this, &Stress::OnSet), i)));
+   }
+   mDone.connect(sigc::mem_fun(this, &Stress::OnProducerDone));
+}
+
+
+Stress::~Stress()
+{
+   for (int i = 0; i < N_PROPERTIES; i++) {
+      delete mProperties[i];
+   }
+}
+
+
+void
+Stress::Run(void)
+{
+   mRunning = N_PRODUCERS;
+   for (int i = 0; i < N_PRODUCERS; i++) {
+      mThreads.push_back(Glib::Thread::create(
+         sigc::bind(sigc::mem_fun(this, &Stress::Produce), i), true));
+   }
+   mLoop->run();
+
+   Check(mOrdered, "posts from one thread are applied in order");
+
+   bool latest = true;
+   for (int i = 0; i < N_PROPERTIES; i++) {
+      latest = latest && mLatest[i].first >= 0 &&
+               mLatest[i].second == GetLastPost(mLatest[i].first, i);
+   }
+   Check(latest, "every property ends on a thread's last post");
+   Check(mFired > 0 && mFired <= N_PRODUCERS * N_POSTS,
+         "the trigger is called at most once per fire");
+
+   printf("%d posts applied as %d sets and %d fires as %d calls\n",
+          N_PRODUCERS * N_POSTS, mApplied, N_PRODUCERS * N_POSTS, mFired);
+}
+
+
+void
+Stress::Produce(int producer) // IN:
+{
+   for (int k = 0; k < N_POSTS; k++) {
+      mProperties[(k + producer) % N_PROPERTIES]->Set(Post(producer, k));
+      mTrigger.Fire();
+   }
+   mDone.emit();
+}
+
+
+void
+Stress::OnProducerDone(void)
+{
+   if (--mRunning > 0) {
+      return;
+   }
+
+   for (size_t i = 0; i < mThreads.size(); i++) {
+      mThreads[i]->join();
+   }
+   mThreads.clear();
+
+   // Whatever the last posts queued may not have been dispatched yet.
+   view::MainThreadDispatcher::Flush();
+   mLoop->quit();
+}
+
+
+void
+Stress::OnSet(const Post &post, // IN:
+              int property)     // IN:
+{
+   int &seen = mSeen[property][post.first];
+   if (post.second <= seen) {
+      mOrdered = false;
+   }
+   seen = post.second;
+   mLatest[property] = post;
+   mApplied++;
+}
+
+
+void
+Stress::OnFired(void)
+{
+   mFired++;
+}
+
+
+int
+Stress::GetLastPost(int producer, // IN:
+                    int property) // IN:
+{
+   int k = N_POSTS - 1;
+   while ((k + producer) % N_PROPERTIES != property) {
+      k--;
+   }
+   return k;
+}
+
+
+static void
+Record(const Post &post,        // IN: Unused
+       std::vector<int> *order, // IN/OUT:
+       int id)                  // IN:
+{
+   order->push_back(id);
+}
+
+
+static void
+DeleteProperty(PostProperty **property) // IN/OUT:
+{
+   delete *property;
+   *property = NULL;
+}
+
+
+static bool
+IsOrder(const std::vector<int> &order, // IN:
+        int a,                         // IN:
+        int b,                         // IN:
+        int c = -1)                    // IN:
+{
+   std::vector<int> expected;
+   expected.push_back(a);
+   expected.push_back(b);
+   if (c >= 0) {
+      expected.push_back(c);
+   }
+   return order == expected;
+}
+
+
+static void
+CheckOrder(void)
+{
+   std::vector<int> order;
+   PostProperty p0(sigc::bind(sigc::ptr_fun(&Record), &order, 0));
+   PostProperty p1(sigc::bind(sigc::ptr_fun(&Record), &order, 1));
+   PostProperty p2(sigc::bind(sigc::ptr_fun(&Record), &order, 2));
+
+   p0.Set(Post(0, 0));
+   p1.Set(Post(0, 0));
+   p2.Set(Post(0, 0));
+   p0.Set(Post(0, 1));
+   view::MainThreadDispatcher::Flush();
+   Check(IsOrder(order, 0, 1, 2), "updates are applied in the order first queued");
+
+   order.clear();
+   p2.Set(Post(0, 0));
+   p0.Set(Post(0, 0));
+   view::MainThreadDispatcher::Flush();
+   Check(IsOrder(order, 2, 0), "applied updates can be queued again");
+
+   /*
+    * Cancel the oldest, a middle and the newest of three queued updates.
+    */
+   static const char *what[] = {
+      "destroying the oldest queued update cancels it",
+      "destroying a middle queued update cancels it",
+      "destroying the newest queued update cancels it",
+   };
+   for (int victim = 0; victim < 3; victim++) {
+      std::vector<PostProperty *> properties;
+      for (int i = 0; i < 3; i++) {
+         properties.push_back(new PostProperty(
+            sigc::bind(sigc::ptr_fun(&Record), &order, i)));
+      }
+
+      order.clear();
+      for (int i = 0; i < 3; i++) {
+         properties[i]->Set(Post(0, 0));
+      }
+      delete properties[victim];
+      properties[victim] = NULL;
+      view::MainThreadDispatcher::Flush();
+
+      std::vector<int> expected;
+      for (int i = 0; i < 3; i++) {
+         if (i != victim) {
+            expected.push_back(i);
+         }
+         delete properties[i];
+      }
+      Check(order == expected, what[victim]);
+   }
+
+   /*
+    * An update being applied destroys one further down the batch.
+    */
+   PostProperty *victim = new PostProperty(
+      sigc::bind(sigc::ptr_fun(&Record), &order, 3));
+   Trigger killer(sigc::bind(sigc::ptr_fun(&DeleteProperty), &victim));
+
+   order.clear();
+   killer.Fire();
+   victim->Set(Post(0, 0));
+   p0.Set(Post(0, 0));
+   view::MainThreadDispatcher::Flush();
+   Check(!victim && order.size() == 1 && order[0] == 0,
+         "an update can destroy another during a flush");
+}
+
+
+int
+main(int argc,     // IN:
+     char *argv[]) // IN:
+{
+   Glib::init();
+
+   {
+      Stress stress;
+      stress.Run();
+   }
+   CheckOrder();
+
+   return sFailures ? 1 : 0;
+}
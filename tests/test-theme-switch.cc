@@ -0,0 +1,142 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+
+
+/*
+ * test-theme-switch.cc
+ *
+ *      A benchmark for how long a theme change takes on a large form.
+ *      Fills a window with rows of view::DeadEntry, view::IPEntry and
+ *      ViewOvBox widgets, then switches the font back and forth, which
+ *      sets a new style on every widget just like a theme change does,
+ *      and times each switch until the main loop is idle again.
+ *
+ *      Usage: test-theme-switch [rows [switches]]
+ */
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <gtkmm/box.h>
+#include <gtkmm/label.h>
+#include <gtkmm/main.h>
+#include <gtkmm/scrolledwindow.h>
+#include <gtkmm/settings.h>
+#include <gtkmm/window.h>
+#include <libview/deadEntry.hh>
+#include <libview/ipEntry.hh>
+#include <libview/ovBox.h>
+
+
+static unsigned int sStyleSets = 0;
+
+
+static void
+OnStyleChanged(const Glib::RefPtr<Gtk::Style> &previousStyle) // IN: Unused
+{
+   sStyleSets++;
+}
+
+
+static void
+RunPending(void)
+{
+   while (Gtk::Main::events_pending()) {
+      Gtk::Main::iteration();
+   }
+}
+
+
+int
+main(int argc,     // IN:
+     char *argv[]) // IN:
+{
+   Gtk::Main kit(&argc, &argv);
+
+   int rows = argc > 1 ? atoi(argv[1]) : 200;
+   int switches = argc > 2 ? atoi(argv[2]) : 10;
+
+   Gtk::Window window;
+   window.set_title("Theme Switch Benchmark");
+   window.set_default_size(400, 600);
+
+   Gtk::ScrolledWindow *scroller = Gtk::manage(new Gtk::ScrolledWindow());
+   scroller->set_policy(Gtk::POLICY_NEVER, Gtk::POLICY_AUTOMATIC);
+   window.add(*scroller);
+
+   Gtk::VBox *vbox = Gtk::manage(new Gtk::VBox(false, 6));
+   scroller->add(*vbox);
+
+   for (int i = 0; i < rows; i++) {
+      Gtk::HBox *hbox = Gtk::manage(new Gtk::HBox(false, 6));
+      vbox->pack_start(*hbox, false, false);
+
+      view::DeadEntry *deadEntry = Gtk::manage(new view::DeadEntry());
+      deadEntry->set_text("view::DeadEntry");
+      // Every other one keeps the insensitive colours of a non-editable entry.
+      deadEntry->set_editable(i % 2 != 0);
+      deadEntry->signal_style_changed().connect(sigc::ptr_fun(OnStyleChanged));
+      hbox->pack_start(*deadEntry);
+
+      view::IPEntry *ipEntry = Gtk::manage(new view::IPEntry());
+      ipEntry->SetIP("192.168.0.1");
+      ipEntry->signal_style_changed().connect(sigc::ptr_fun(OnStyleChanged));
+      hbox->pack_start(*ipEntry);
+
+      GtkWidget *ovBox = GTK_WIDGET(ViewOvBox_New());
+      ViewOvBox_SetUnder(VIEW_OV_BOX(ovBox),
+                         GTK_WIDGET(Gtk::manage(new Gtk::Label("Under"))->gobj()));
+      ViewOvBox_SetOver(VIEW_OV_BOX(ovBox),
+                        GTK_WIDGET(Gtk::manage(new Gtk::Label("Over"))->gobj()));
+      hbox->pack_start(*Gtk::manage(Glib::wrap(ovBox)));
+   }
+
+   window.show_all();
+   RunPending();
+
+   Glib::RefPtr<Gtk::Settings> settings = Gtk::Settings::get_default();
+   Glib::ustring fonts[] = { "Sans 11", "Sans 10" };
+
+   GTimer *timer = g_timer_new();
+   double total = 0;
+   sStyleSets = 0;
+
+   for (int i = 0; i < switches; i++) {
+      g_timer_start(timer);
+      settings->property_gtk_font_name() = fonts[i % 2];
+      RunPending();
+      double elapsed = g_timer_elapsed(timer, NULL);
+
+      printf("switch %2d: %8.2f ms\n", i, elapsed * 1e3);
+      total += elapsed;
+   }
+   g_timer_destroy(timer);
+
+   if (switches > 0 && rows > 0) {
+      printf("%d rows: %.2f ms per switch, %.2f style sets per entry per switch\n",
+             rows, total * 1e3 / switches,
+             (double)sStyleSets / (2 * rows * switches));
+   }
+
+   return 0;
+}
@@ -0,0 +1,179 @@
+/* *************************************************************************
+ * Copyright (c) 2005 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * *************************************************************************/
+/*
+ * test-virtual-list.cc
+ *
+ *      A test program that demonstrates the view::VirtualList widget.
+ *
+ *      When running this test, check that:
+ *        * Scrolling through all the rows is smooth, and only about a
+ *          window's worth of row widgets exist at any time.
+ *        * The rows are as wide as the window and wrap to its width.
+ *        * The window can be made narrower again after being widened.
+ *        * Adding or removing rows keeps the top row where it is.
+ */
+
+
+#include <algorithm>
+#include <cstdio>
+#include <gtkmm/box.h>
+#include <gtkmm/button.h>
+#include <gtkmm/main.h>
+#include <gtkmm/scrolledwindow.h>
+#include <gtkmm/window.h>
+#include <libview/virtualList.hh>
+#include <libview/wrapLabel.hh>
+
+
+static const char *sWords[] = {
+   "Lorem", "ipsum", "dolor", "sit", "amet,", "consectetur", "adipiscing",
+   "elit,", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore",
+};
+
+
+class RowModel
+   : public view::VirtualList::Model
+{
+public:
+   RowModel() : mCount(100000) {}
+
+   size_t GetRowCount(void) const { return mCount; }
+   void SetRowCount(size_t count) { mCount = count; rowsChanged.emit(); }
+
+private:
+   size_t mCount;
+};
+
+
+class AppWindow
+   : public Gtk::Window
+{
+public:
+   AppWindow();
+
+private:
+   static Gtk::Widget *CreateRow(void);
+   static void BindRow(Gtk::Widget &widget, size_t row);
+   void OnAdd(void);
+   void OnRemove(void);
+
+   RowModel mModel;
+   Gtk::VBox mBox;
+   Gtk::HBox mButtons;
+   Gtk::Button mAdd;
+   Gtk::Button mRemove;
+   Gtk::ScrolledWindow mScroller;
+   view::VirtualList mList;
+};
+
+
+AppWindow::AppWindow()
+   : mBox(false, 6),
+     mButtons(false, 6),
+     mAdd("Add 1000 rows"),
+     mRemove("Remove 1000 rows"),
+     mList(*mScroller.get_hadjustment(), *mScroller.get_vadjustment(),
+           mModel, sigc::ptr_fun(&AppWindow::CreateRow),
+           sigc::ptr_fun(&AppWindow::BindRow))
+{
+   set_title("VirtualList Test");
+   set_border_width(12);
+   set_default_size(400, 500);
+
+   mBox.show();
+   add(mBox);
+
+   mButtons.show();
+   mBox.pack_start(mButtons, false, false);
+
+   mAdd.show();
+   mButtons.pack_start(mAdd, false, false);
+   mAdd.signal_clicked().connect(sigc::mem_fun(this, &AppWindow::OnAdd));
+
+   mRemove.show();
+   mButtons.pack_start(mRemove, false, false);
+   mRemove.signal_clicked().connect(sigc::mem_fun(this, &AppWindow::OnRemove));
+
+   /*
+    * No horizontal scrollbar, so the window can only be made narrower if
+    * the rows don't hold the list open.
+    */
+   mScroller.set_policy(Gtk::POLICY_NEVER, Gtk::POLICY_AUTOMATIC);
+   mScroller.show();
+   mBox.pack_start(mScroller);
+
+   mList.show();
+   mScroller.add(mList);
+}
+
+
+Gtk::Widget *
+AppWindow::CreateRow(void)
+{
+   view::WrapLabel *label = new view::WrapLabel();
+   label->set_alignment(0, 0);
+   return label;
+}
+
+
+void
+AppWindow::BindRow(Gtk::Widget &widget, // IN
+                   size_t row)          // IN
+{
+   char header[64];
+   snprintf(header, sizeof header, "<b>Row %lu:</b>", (unsigned long)row);
+
+   Glib::ustring text = header;
+   for (size_t i = 0; i < row % 40 + 1; i++) {
+      text += " ";
+      text += sWords[(row + i) % G_N_ELEMENTS(sWords)];
+   }
+   static_cast<view::WrapLabel &>(widget).set_markup(text);
+}
+
+
+void
+AppWindow::OnAdd(void)
+{
+   mModel.SetRowCount(mModel.GetRowCount() + 1000);
+}
+
+
+void
+AppWindow::OnRemove(void)
+{
+   mModel.SetRowCount(mModel.GetRowCount() - std::min(mModel.GetRowCount(),
+                                                      (size_t)1000));
+}
+
+
+int
+main(int argc,     // IN:
+     char *argv[]) // IN:
+{
+   Gtk::Main kit(&argc, &argv);
+   AppWindow app;
+   Gtk::Main::run(app);
+
+   return 0;
+}